@@ -8,10 +8,10 @@
  * Context: First version
  *
  * 本程序为根据实测电场计算准双极源电阻率的程序，先读出实测电场，然后根据其反算电阻率。
- * 假设收发距为R，AB相距L，根据计算的结果，即使R=L的近收发距的情况，如果将AB剖分成100个首尾相连的小电偶极子，
- * 那么不论观测点与AB成什么角度，其小电偶
- * 极子在该处产生的场强与真双极源在该处产生的场强相比，其误差均小于1%。
- * 因此本程序采用将AB电偶极子剖分成100个首尾相连的小电偶极子的方式进行计算。
+ * Ex为AB上各小电偶极子的场沿AB的积分。原来把AB剖分成NDIV(100)个首尾相连的小电偶极子，
+ * 近收发距时误差约1%；现在按站点的最高频率用自适应Gauss-Legendre求积定节点(abRule)，
+ * 直流和最高频率两种极端下沿AB积分的相对误差都不超过给定容差，站点各频点共用同一组节点。
+ * 容差由RHOSOLVER文件中的[Quadrature] Tol设置，默认RHO_QUAD_TOL；Tol <= 0 时仍按NDIV段中点公式计算。
  */
 #include "CalRhoThread.h"
 
@@ -21,39 +21,274 @@
  *
  */
 CalRhoThread::CalRhoThread(MyDatabase *poDatabase, QObject *parent) :
-    QThread(parent)
+    QObject(parent)
 {
     poDb = poDatabase;
+
+    giDone  = 0;
+    giTotal = 0;
+    giFailed = 0;
+    giKernel = 0;
+    giPoints = 0;
+
+    /* 没有配置文件时用默认值 */
+    QSettings oSettings(RHOSOLVER, QSettings::IniFormat);
+
+    gsSolverOpt = RhoSolver::defaultOpt();
+    gsSolverOpt.dTol = oSettings.value("Solver/Tol", gsSolverOpt.dTol).toDouble();
+    gsSolverOpt.iMaxIter = oSettings.value("Solver/MaxIter", gsSolverOpt.iMaxIter).toInt();
+
+    gdQuadTol = oSettings.value("Quadrature/Tol", RHO_QUAD_TOL).toDouble();
+
+    /* 建一张表约要71次正演，逐点迭代约3次，表只在本次运行中有效；
+     * 同一站点反复改场值重算时才值得打开 */
+    gbTable = oSettings.value("Solver/Table", false).toBool();
+
+    gocTable.setMaxCost(RHO_TABLE_CACHE_KB);
+
+    poWatcher = new QFutureWatcher<RHO_OUTPUT>(this);
+
+    connect(poWatcher, SIGNAL(resultReadyAt(int)), this, SLOT(resultReady(int)));
+    connect(poWatcher, SIGNAL(finished()), this, SLOT(finished()));
 }
 
 /****************************************************************************
  * CalRhoThread : unconstructure
- *
+ * 还在算的话等线程池中的任务结束，任务不引用本对象
  */
 CalRhoThread::~CalRhoThread()
 {
+    poWatcher->cancel();
+    poWatcher->waitForFinished();
+}
 
+bool CalRhoThread::isRunning()
+{
+    return poWatcher->isRunning();
+}
+
+void CalRhoThread::cancel()
+{
+    poWatcher->cancel();
 }
 
 /**********************************************************************************
- * Calculate the WFEM ρ in a single thread.
- * (Translation from MATLAB program)
- *
+ * 并行计算各站点的广域视电阻率
+ * 输入先取好，再交给线程池(线程数 = CPU核数)，每个站点一个任务，空闲的线程取下一个站点。
+ * 结果按完成的先后逐个送回GUI线程(resultReady)，不等全部算完。
  */
-void CalRhoThread::CalRho(STATION oStation)
+void CalRhoThread::CalRho(QList<STATION> aoStation)
 {
-    /* Read coordinate from coordinate file */
-    if(!this->CoorRead(oStation))
+    if(this->isRunning())
     {
-        emit SigMsg(QString("线号：%1\n点号：%2\n坐标获取失败！")
-                    .arg(oStation.oStrLineId)
-                    .arg(oStation.oStrSiteId));
-
         return;
     }
 
-    /* AB Dipole length */
-    double dL = LengthGet(ptA, ptB)/NDIV;
+    QStringList aoStrErr;
+
+    QList<RHO_JOB> aoJob = this->prepare(aoStation, aoStrErr);
+
+    if(!aoStrErr.isEmpty())
+    {
+        emit SigMsg(QString("%1个站点坐标获取失败，未计算：\n%2")
+                    .arg(aoStrErr.count())
+                    .arg(aoStrErr.mid(0, 10).join("\n")));
+    }
+
+    giDone  = 0;
+    giTotal = aoJob.count();
+    giFailed = 0;
+    giKernel = 0;
+    giPoints = 0;
+
+    gaoPending.clear();
+
+    goTimer.start();
+
+    poWatcher->setFuture(QtConcurrent::mapped(aoJob, CalRhoThread::runJob));
+}
+
+/* 取坐标和频点都要读数据库，只在GUI线程中做 */
+QList<RHO_JOB> CalRhoThread::prepare(QList<STATION> aoStation, QStringList &aoStrErr)
+{
+    QList<RHO_JOB> aoJob;
+
+    foreach(STATION oStation, aoStation)
+    {
+        RHO_JOB sJob;
+
+        sJob.oStation = oStation;
+
+        sJob.oAB = oAB;
+
+        sJob.sOpt = gsSolverOpt;
+        sJob.dQuadTol = gdQuadTol;
+
+        /* 上次算过的站点带上它的表 */
+        sJob.bTable = gbTable;
+
+        if(gbTable && gocTable.contains(tableKey(oStation)))
+        {
+            sJob.sTable = *gocTable.object(tableKey(oStation));
+        }
+
+        /* RX, Line Site*/
+        sJob.oMN = poDb->getCoordinate(oStation.oStrLineId, oStation.oStrSiteId);
+
+        const Position &oMN = sJob.oMN;
+
+        if(oMN.dMX == 0 && oMN.dMY == 0 && oMN.dMZ == 0 && oMN.dNX == 0 && oMN.dNY == 0 && oMN.dNZ == 0 )
+        {
+            aoStrErr.append(QString("线号：%1 点号：%2")
+                            .arg(oStation.oStrLineId)
+                            .arg(oStation.oStrSiteId));
+            continue;
+        }
+
+        /* Frequency list, with current, field and error of every frequency */
+        sJob.sSpectrum = poDb->getSpectrum(oStation);
+
+        aoJob.append(sJob);
+    }
+
+    return aoJob;
+}
+
+/* 一个站点算完：画曲线，结果攒起来 */
+void CalRhoThread::resultReady(int iIndex)
+{
+    RHO_OUTPUT sOutput = poWatcher->resultAt(iIndex);
+
+    QList<RhoResult> &aoRhoResult = sOutput.aoRhoResult;
+
+    giDone++;
+
+    /* 表留着，改了场值重算时用 */
+    if(gbTable && !aoRhoResult.isEmpty() && !sOutput.sTable.mapTable.isEmpty())
+    {
+        int iCost = sOutput.sTable.mapTable.count()*RhoTable::grid().count()*2*sizeof(double)/1024 + 1;
+
+        gocTable.insert(tableKey(aoRhoResult.first().oStation), new RHO_STATION_TABLE(sOutput.sTable), iCost);
+    }
+
+    if(!aoRhoResult.isEmpty())
+    {
+        QVector<double> adF, adRho;
+
+        foreach(RhoResult oRhoResult, aoRhoResult)
+        {
+            adF.append(oRhoResult.dF);
+            adRho.append(oRhoResult.dRho);
+
+            if(!oRhoResult.bConverged)
+            {
+                giFailed++;
+            }
+
+            giKernel += oRhoResult.iKernel;
+            giPoints++;
+        }
+
+        gaoPending.append(aoRhoResult);
+
+        if(gaoPending.count() >= DB_BATCH_ROWS)
+        {
+            this->flush();
+        }
+
+        emit SigRho(aoRhoResult.first().oStation, adF, adRho);
+    }
+
+    emit SigProgress(giDone, giTotal, this->rate());
+}
+
+void CalRhoThread::finished()
+{
+    this->flush();
+
+    qDebugV0()<<"CalRho stations:"<<giDone<<"/"<<giTotal
+             <<"seconds:"<<goTimer.elapsed()/1000.0
+            <<"stations/s:"<<this->rate()
+           <<"canceled:"<<poWatcher->isCanceled()
+          <<"not converged:"<<giFailed
+         <<"kernel evals/point:"<<(giPoints > 0 ? double(giKernel)/giPoints : 0);
+
+    if(giFailed > 0)
+    {
+        emit SigMsg(QString("%1个频点的视电阻率未收敛(容差%2，最多%3次正演)，\n见Rho表中的收敛列。")
+                    .arg(giFailed)
+                    .arg(gsSolverOpt.dTol)
+                    .arg(gsSolverOpt.iMaxIter));
+    }
+
+    emit SigFinished(giDone, giTotal, this->rate());
+}
+
+void CalRhoThread::flush()
+{
+    if(!gaoPending.isEmpty())
+    {
+        poDb->importRho(gaoPending);
+
+        gaoPending.clear();
+    }
+}
+
+QString CalRhoThread::tableKey(const STATION &oStation)
+{
+    return QString("%1/%2/%3/%4/%5")
+            .arg(oStation.oStrLineId)
+            .arg(oStation.oStrSiteId)
+            .arg(oStation.iDevId)
+            .arg(oStation.iDevCh)
+            .arg(oStation.oStrTag);
+}
+
+/* 站点/秒 */
+double CalRhoThread::rate()
+{
+    qint64 iMs = goTimer.elapsed();
+
+    return (iMs > 0) ? giDone*1000.0/iMs : 0;
+}
+
+static bool samePosition(const Position &oPos1, const Position &oPos2)
+{
+    return oPos1.dMX == oPos2.dMX && oPos1.dMY == oPos2.dMY && oPos1.dMZ == oPos2.dMZ &&
+            oPos1.dNX == oPos2.dNX && oPos1.dNY == oPos2.dNY && oPos1.dNZ == oPos2.dNZ;
+}
+
+/* 线程池中执行：带着GUI线程给的表计算，表(可能新建了一些频点)随结果带回 */
+RHO_OUTPUT CalRhoThread::runJob(const RHO_JOB &sJob)
+{
+    RHO_OUTPUT sOutput;
+
+    sOutput.sTable = sJob.sTable;
+
+    sOutput.aoRhoResult = calStation(sJob, sJob.bTable ? &sOutput.sTable : NULL);
+
+    return sOutput;
+}
+
+/**********************************************************************************
+ * Calculate the WFEM ρ for one station.
+ * (Translation from MATLAB program)
+ *
+ */
+QList<RhoResult> CalRhoThread::calStation(const RHO_JOB &sJob, RHO_STATION_TABLE *psTable)
+{
+    const STATION &oStation = sJob.oStation;
+
+    const Position &oAB = sJob.oAB;
+    const Position &oMN = sJob.oMN;
+
+    QPointF ptA(oAB.dMX, oAB.dMY);
+    QPointF ptB(oAB.dNX, oAB.dNY);
+    QPointF ptTxMid( (ptA.x() + ptB.x())/2, (ptA.y() + ptB.y())/2 );
+
+    QPointF ptM(oMN.dMX, oMN.dMY);
+    QPointF ptN(oMN.dNX, oMN.dNY);
+    QPointF ptRxMid( (ptM.x() + ptN.x())/2, (ptM.y() + ptN.y())/2 );
 
     /* AB length */
     double dLPhi = LengthGet(ptA, ptB);
@@ -61,13 +296,40 @@ void CalRhoThread::CalRho(STATION oStation)
     /* M--->N length */
     double dMN = LengthGet(ptM, ptN);
 
-    /* Frequency list */
-    QVector<double> adF;
-    adF.clear();
-    adF = poDb->getF(oStation);
+    /* Ex：求积节点和各节点的几何量与ρ无关，按站点的最高频率定好节点，各频点共用 */
+    DIPOLE_GEOM sGeom;
+    sGeom.iEvals = 0;
+
+    double dFMax = 0;
+
+    if(oStation.oStrTag == "Ex" && !sJob.sSpectrum.adF.isEmpty())
+    {
+        dFMax = *std::max_element(sJob.sSpectrum.adF.constBegin(), sJob.sSpectrum.adF.constEnd());
+
+        sGeom = dipoleGeom(oAB, oMN, abRule(oAB, oMN, dFMax, sJob.dQuadTol));
+    }
+
+    /* 建节点时的核函数次数记在第一个频点上 */
+    int iKernel = sGeom.iEvals;
+
+    /* 坐标、求积容差或最高频率变了，求积节点不同，原来的表都不能用 */
+    if(psTable != NULL && (psTable->mapTable.isEmpty() || !(samePosition(psTable->oAB, oAB) &&
+                                                            samePosition(psTable->oMN, oMN) &&
+                                                            psTable->dQuadTol == sJob.dQuadTol &&
+                                                            psTable->dFMax == dFMax)))
+    {
+        psTable->oAB = oAB;
+        psTable->oMN = oMN;
+        psTable->dQuadTol = sJob.dQuadTol;
+        psTable->dFMax = dFMax;
+
+        psTable->mapTable.clear();
+    }
 
-    QVector<double> adRho;
-    adRho.clear();
+    /* Frequency list, with current, field and error of every frequency */
+    const SPECTRUM &sSpectrum = sJob.sSpectrum;
+
+    const QVector<double> &adF = sSpectrum.adF;
 
     /* Rho list */
     QList<RhoResult> aoRhoResult;
@@ -80,16 +342,24 @@ void CalRhoThread::CalRho(STATION oStation)
     std::complex<double> NEGONE(-1, 0);
 
     /* Loop1: Frequency count */
-    foreach(double dF, adF)
+    for(int i = 0; i < adF.count(); i++)
     {
-        double dI = poDb->getI(dF);
+        double dF = adF.at(i);
+
+        double dI = sSpectrum.adI.at(i);
 
-        double dField = poDb->getField(oStation, dF);
+        double dField = sSpectrum.adField.at(i);
 
-        double dErr = poDb->getErr(oStation, dF);
+        double dErr = sSpectrum.adErr.at(i);
 
-        double dRho0 = 10;
-        double dRho  = 100;
+        double dRho = 0;
+
+        /* 反演诊断；Ey直接算出，不迭代 */
+        SOLVER_RESULT sSolve;
+        sSolve.dRho = 0;
+        sSolve.iIter = 0;
+        sSolve.dResidual = 0;
+        sSolve.bConverged = false;
 
         /* 电场值（单位：伏/米） 2017-03-10 */
         double dE = ( dField*UU )/dMN;
@@ -113,67 +383,91 @@ void CalRhoThread::CalRho(STATION oStation)
 
             /* pey= abs( 2*pi  *r^3        *Ey/(3*I.       *L    *(sin(a).  *cos(a)   ))) */
             dRho = qAbs( 2*M_PI*pow(dR, 3) *dE/(3*dI*dLPhi*(sin(dPhi)*cos(dPhi))));
+
+            sSolve.bConverged = std::isfinite(dRho);
         }
         else
         {
-            /* Error upper limit */
-            while( qAbs( (dRho - dRho0)/dRho0 ) >= ERR )
-            {
-                dRho0 = dRho;
+            /* 正演：ρ对应的单位电流场强 |E(ρ)/I| = ρ·|cca(ρ)/I|，cca为单位电阻率的场 */
+            std::function<double(double)> oForward;
 
-                std::complex<double> cca(0, 0);
+            /* 一次算一组ρ，建表用；没有时逐个调oForward */
+            std::function<void(const double*, int, double*)> oBatch;
 
-                if(oStation.oStrTag == "Ex")
+            if(oStation.oStrTag == "Ex")
+            {
+                oForward = [&](double dRho0) -> double
                 {
-                    /* Loop2: ndiv, 100 */
-                    for(qint32 j = 1; j < NDIV +1; j++)
-                    {
-                        //qDebugV0()<<"Loop1/Loop2:"<<i<<"("<<adF.at(i)<<") "<<"/"<<j<<"No./100:"<<j<<"/100";
-                        //center_x(ii) =     xa         + (xb         - xa        )/2/nn  *(2*ii-1);
-                        QPointF ptDipoleMid( ptA.x() + (ptB.x() - ptA.x())/2/NDIV*(2*j-1),
-                                             ptA.y() + (ptB.y() - ptA.y())/2/NDIV*(2*j-1));
+                    /* k与小偶极子无关，每次正演算一次 */
+                    std::complex<double> k2( EPSILON*MU*pow(dW, 2), dW*MU/dRho0 );
 
-                        /* Dipole_Mid --> point length */
-                        double dR = LengthGet(ptDipoleMid, ptRxMid);
+                    std::complex<double> k = sqrt(k2);
 
-                        //qDebugV0()<<"Dipole_Mid --> point length:"<<dR;
+                    /* Loop2: 沿AB各求积节点 */
+                    return dRho0*abs(exSum(sGeom, k));
+                };
 
-                        /* DipoleMid_point------>AB angle */
-                        double dPhi = AngleGet(ptA, ptB, ptRxMid, ptDipoleMid);
+                oBatch = [&](const double *pdRho, int iCnt, double *pdE)
+                {
+                    exTable(sGeom, dW, pdRho, iCnt, pdE);
+                };
+            }
+            else if(oStation.oStrTag == "E\u03c6")/* Eφ */
+            {
+                /* AB_Mid --> point length */
+                double dR = LengthGet(ptTxMid, ptRxMid);
 
-                        //qDebugV0()<<"DipoleMid_point------>AB angle:"<<dPhi;
+                /* DipoleMid_point------>AB angle */
+                double dPhi = AngleGet(ptA, ptB, ptTxMid, ptRxMid);
 
-                        double dCc = (dI*dL)/(2*M_PI*(pow(dR, 3)));
+                std::complex<double> coef1 = dLPhi*sin(dPhi)/(2*M_PI*pow(dR, 3));
 
-                        std::complex<double> k2( EPSILON*MU*pow(dW, 2), dW*MU/dRho0 );
+                oForward = [&, dR, coef1](double dRho0) -> double
+                {
+                    std::complex<double> k2 = EPSILON*MU*pow(dW, 2) - IMAGE*dW*MU/dRho0;
 
-                        std::complex<double> k = sqrt(k2);
+                    std::complex<double> k = sqrt(k2);
 
-                        //  = cca + cc(ii)*(1-3*sin(phi(ii))*sin(phi(ii))+exp(i    *k*r(ii))- i    *k*r(ii)*exp(i    *k*r(ii)));
-                        cca = cca + dCc   *(1-3*sin(dPhi)   *sin(dPhi)   +exp(IMAGE*k*dR   )- IMAGE*k*dR   *exp(IMAGE*k*dR   ));
+                    std::complex<double> coef2 = TWO - exp(NEGONE*IMAGE*k*dR)*(ONE+IMAGE*k*dR);
 
-                    }
-                }
+                    return dRho0*abs(coef1*coef2);
+                };
+            }
 
-                else if(oStation.oStrTag == "E\u03c6")/* Eφ */
+            if(oForward && !oBatch)
+            {
+                oBatch = [&](const double *pdRho, int iCnt, double *pdE)
                 {
-                    /* AB_Mid --> point length */
-                    double dR = LengthGet(ptTxMid, ptRxMid);
-
-                    /* DipoleMid_point------>AB angle */
-                    double dPhi = AngleGet(ptA, ptB, ptTxMid, ptRxMid);
+                    for(int m = 0; m < iCnt; m++)
+                    {
+                        pdE[m] = oForward(pdRho[m]);
+                    }
+                };
+            }
 
-                    std::complex<double> k2 = EPSILON*MU*pow(dW, 2) - IMAGE*dW*MU/dRho0;
+            /* 实测的单位电流场强 */
+            double dTarget = qAbs(dE/dI);
 
-                    std::complex<double> k = sqrt(k2);
+            if(oForward && psTable != NULL)
+            {
+                /* 这个频点还没有表：建表，之后重算直接查 */
+                if(!psTable->mapTable.contains(dF))
+                {
+                    RHO_TABLE sTable = RhoTable::build(oBatch);
 
-                    std::complex<double> coef1 = dI*dLPhi*sin(dPhi)/(2*M_PI*pow(dR, 3));
-                    std::complex<double> coef2 = TWO - exp(NEGONE*IMAGE*k*dR)*(ONE+IMAGE*k*dR);
+                    iKernel += sTable.adLogRho.count()*sGeom.adR.count();
 
-                    cca = coef1*coef2;
+                    psTable->mapTable.insert(dF, sTable);
                 }
-                dRho = abs(dE/cca);
+
+                sSolve = RhoTable::invert(psTable->mapTable.value(dF), oForward, dTarget, 100, sJob.sOpt);
+            }
+            else if(oForward)
+            {
+                sSolve = RhoSolver::solve(oForward, dTarget, 100, sJob.sOpt);
             }
+
+            dRho = sSolve.dRho;
         }
 
         RhoResult oRhoResult;
@@ -189,61 +483,203 @@ void CalRhoThread::CalRho(STATION oStation)
         oRhoResult.dErr = dErr;
         oRhoResult.dRho = dRho;
 
-        adRho.append(dRho);
+        oRhoResult.iIter = sSolve.iIter;
+        oRhoResult.dResidual = sSolve.dResidual*100;
+        oRhoResult.bConverged = sSolve.bConverged;
+
+        oRhoResult.iKernel = iKernel + sSolve.iIter*sGeom.adR.count();
+        iKernel = 0;
 
         aoRhoResult.append(oRhoResult);
     }
 
-    poDb->importRho(aoRhoResult);
+    return aoRhoResult;
+}
+
+/* AB上t(0~1)处到测点的距离和sinφ，φ为该点-测点连线与AB的夹角 */
+static void abPoint(const QPointF &ptA, const QPointF &ptB, const QPointF &ptRxMid, double dT, double &dR, double &dSin)
+{
+    //center_x(ii) =     xa         + (xb         - xa        )/2/nn  *(2*ii-1);
+    QPointF ptDipoleMid( ptA.x() + (ptB.x() - ptA.x())*dT,
+                         ptA.y() + (ptB.y() - ptA.y())*dT );
+
+    /* Dipole_Mid --> point length */
+    dR = CalRhoThread::LengthGet(ptDipoleMid, ptRxMid);
 
-    emit SigRho(oStation, adF, adRho);
+    /* DipoleMid_point------>AB angle */
+    dSin = sin(CalRhoThread::AngleGet(ptA, ptB, ptRxMid, ptDipoleMid));
 }
 
-bool CalRhoThread::getAB()
+/**********************************************************************************
+ * 沿AB的求积节点。被积函数即单个小偶极子的场(不含电流和ρ)：
+ * f(t) = (1 - 3sin²φ + e^(ikr)(1 - ikr))/r³
+ * 同时检查k = 0(直流，近源时1/r³最陡)和k = kMax(最高频率、ρ = RHO_QUAD_RHO_MIN，振荡最快)两个分量，
+ * 这两种情况都满足容差，站点各频点、反演中的各ρ都满足。
+ * dTol <= 0 时按原来的NDIV段中点公式。
+ */
+QUAD_RULE CalRhoThread::abRule(const Position &oAB, const Position &oMN, double dFMax, double dTol)
 {
-    /* TX, AB */
-    oAB = poDb->getCoordinate("A", "B");
+    if(dTol <= 0)
+    {
+        return Quadrature::midpoint(NDIV);
+    }
 
-    if(oAB.dMX == 0 && oAB.dMY == 0 && oAB.dMZ == 0 && oAB.dNX == 0 && oAB.dNY == 0 && oAB.dNZ == 0 )
+    QPointF ptA(oAB.dMX, oAB.dMY);
+    QPointF ptB(oAB.dNX, oAB.dNY);
+
+    QPointF ptRxMid( (oMN.dMX + oMN.dNX)/2, (oMN.dMY + oMN.dNY)/2 );
+
+    double dW = dFMax*2*M_PI;
+
+    const std::complex<double> IMAGE(0, 1);
+    const std::complex<double> kMax = sqrt(std::complex<double>( EPSILON*MU*pow(dW, 2), dW*MU/RHO_QUAD_RHO_MIN ));
+
+    std::function<void(double, std::complex<double>*)> oKernel = [&](double dT, std::complex<double> *pcValue)
     {
-        emit SigMsg("AB\n坐标获取失败！");
-        return false;
+        double dR, dSin;
+
+        abPoint(ptA, ptB, ptRxMid, dT, dR, dSin);
+
+        double dR3 = dR*dR*dR;
+
+        pcValue[0] = (2 - 3*dSin*dSin)/dR3;
+        pcValue[1] = (1 - 3*dSin*dSin + exp(IMAGE*kMax*dR)*(1.0 - IMAGE*kMax*dR))/dR3;
+    };
+
+    return Quadrature::adaptive(oKernel, 2, dTol);
+}
+
+/**********************************************************************************
+ * 按求积节点算出各节点相对测点(MN中点)的r、1 - 3sin²φ 和 w·L/(2π r³)，
+ * w为节点的权(和为1)。中点公式下即原来的NDIV个小电偶极子，w·L = dL。
+ */
+DIPOLE_GEOM CalRhoThread::dipoleGeom(const Position &oAB, const Position &oMN, const QUAD_RULE &sRule)
+{
+    QPointF ptA(oAB.dMX, oAB.dMY);
+    QPointF ptB(oAB.dNX, oAB.dNY);
+
+    QPointF ptRxMid( (oMN.dMX + oMN.dNX)/2, (oMN.dMY + oMN.dNY)/2 );
+
+    /* AB length */
+    double dLPhi = LengthGet(ptA, ptB);
+
+    const int iCnt = sRule.adT.count();
+
+    DIPOLE_GEOM sGeom;
+
+    sGeom.adR.resize(iCnt);
+    sGeom.adA.resize(iCnt);
+    sGeom.adG.resize(iCnt);
+
+    sGeom.iEvals = sRule.iEvals;
+
+    for(int j = 0; j < iCnt; j++)
+    {
+        double dR, dSin;
+
+        abPoint(ptA, ptB, ptRxMid, sRule.adT.at(j), dR, dSin);
+
+        sGeom.adR[j] = dR;
+        sGeom.adA[j] = 1 - 3*dSin*dSin;
+        sGeom.adG[j] = sRule.adW.at(j)*dLPhi/(2*M_PI*dR*dR*dR);
     }
 
-    ptA.setX(oAB.dMX);
-    ptA.setY(oAB.dMY);
+    return sGeom;
+}
 
-    ptB.setX(oAB.dNX);
-    ptB.setY(oAB.dNY);
+/**********************************************************************************
+ * cca = Σ cc(ii)*(1-3*sin(phi(ii))^2+exp(i*k*r(ii))-i*k*r(ii)*exp(i*k*r(ii)))
+ * k = kr + i*ki，展开成实数运算：
+ * e^(ikr)(1 - ikr) = e^(-ki*r) * [ cos(kr*r)(1+ki*r) + sin(kr*r)*kr*r
+ *                                + i( sin(kr*r)(1+ki*r) - cos(kr*r)*kr*r ) ]
+ * 循环体内没有复数对象和分支，实部虚部各自累加。
+ */
+std::complex<double> CalRhoThread::exSum(const DIPOLE_GEOM &sGeom, std::complex<double> k)
+{
+    const double dKr = k.real();
+    const double dKi = k.imag();
 
-    ptTxMid.setX( (ptA.x() + ptB.x())/2 );
-    ptTxMid.setY( (ptA.y() + ptB.y())/2 );
+    const double *pdR = sGeom.adR.constData();
+    const double *pdA = sGeom.adA.constData();
+    const double *pdG = sGeom.adG.constData();
 
+    const int iCnt = sGeom.adR.count();
 
-    return true;
+    double dRe = 0, dIm = 0;
+
+    for(int j = 0; j < iCnt; j++)
+    {
+        double dR  = pdR[j];
+        double dE  = exp(-dKi*dR);
+        double dC  = cos(dKr*dR);
+        double dS  = sin(dKr*dR);
+        double dP  = 1 + dKi*dR;
+        double dQ  = dKr*dR;
+
+        dRe += pdG[j]*(pdA[j] + dE*(dC*dP + dS*dQ));
+        dIm += pdG[j]*dE*(dS*dP - dC*dQ);
+    }
+
+    return std::complex<double>(dRe, dIm);
 }
 
-/*****************************************************
- * Get coordinate from coordinate file
- *
+/**********************************************************************************
+ * 一次算出一组ρ的 ρ·|cca/I|，与对每个ρ调exSum相同。
+ * 外层按节点、内层按ρ，内层各ρ互不相关，编译器可以向量化。
  */
-bool CalRhoThread::CoorRead(STATION oStation)
+void CalRhoThread::exTable(const DIPOLE_GEOM &sGeom, double dW, const double *pdRho, int iCnt, double *pdE)
 {
-    /* RX, Line Site*/
-    oMN = poDb->getCoordinate(oStation.oStrLineId, oStation.oStrSiteId);
-    if(oMN.dMX == 0 && oMN.dMY == 0 && oMN.dMZ == 0 && oMN.dNX == 0 && oMN.dNY == 0 && oMN.dNZ == 0 )
+    QVector<double> adKr(iCnt), adKi(iCnt);
+    QVector<double> adRe(iCnt, 0), adIm(iCnt, 0);
+
+    for(int m = 0; m < iCnt; m++)
     {
-        return false;
+        std::complex<double> k = sqrt(std::complex<double>( EPSILON*MU*pow(dW, 2), dW*MU/pdRho[m] ));
+
+        adKr[m] = k.real();
+        adKi[m] = k.imag();
+    }
+
+    const double *pdKr = adKr.constData();
+    const double *pdKi = adKi.constData();
+    double *pdRe = adRe.data();
+    double *pdIm = adIm.data();
+
+    for(int j = 0; j < sGeom.adR.count(); j++)
+    {
+        const double dR = sGeom.adR.at(j);
+        const double dA = sGeom.adA.at(j);
+        const double dG = sGeom.adG.at(j);
+
+        for(int m = 0; m < iCnt; m++)
+        {
+            double dExp = exp(-pdKi[m]*dR);
+            double dC   = cos(pdKr[m]*dR);
+            double dS   = sin(pdKr[m]*dR);
+            double dP   = 1 + pdKi[m]*dR;
+            double dQ   = pdKr[m]*dR;
+
+            pdRe[m] += dG*(dA + dExp*(dC*dP + dS*dQ));
+            pdIm[m] += dG*dExp*(dS*dP - dC*dQ);
+        }
     }
 
-    ptM.setX(oMN.dMX);
-    ptM.setY(oMN.dMY);
+    for(int m = 0; m < iCnt; m++)
+    {
+        pdE[m] = pdRho[m]*sqrt(pdRe[m]*pdRe[m] + pdIm[m]*pdIm[m]);
+    }
+}
 
-    ptN.setX(oMN.dNX);
-    ptN.setY(oMN.dNY);
+bool CalRhoThread::getAB()
+{
+    /* TX, AB */
+    oAB = poDb->getCoordinate("A", "B");
 
-    ptRxMid.setX( (ptM.x() + ptN.x())/2 );
-    ptRxMid.setY( (ptM.y() + ptN.y())/2 );
+    if(oAB.dMX == 0 && oAB.dMY == 0 && oAB.dMZ == 0 && oAB.dNX == 0 && oAB.dNY == 0 && oAB.dNZ == 0 )
+    {
+        emit SigMsg("AB\n坐标获取失败！");
+        return false;
+    }
 
     return true;
 }
@@ -8,22 +8,34 @@
  * Context: First version
  *
  * 本程序为根据实测电场计算准双极源电阻率的程序，先读出实测电场，然后根据其反算电阻率。
- * 假设收发距为R，AB相距L，根据计算的结果，即使R=L的近收发距的情况，如果将AB剖分成100个首尾相连的小电偶极子，
- * 那么不论观测点与AB成什么角度，其小电偶
- * 极子在该处产生的场强与真双极源在该处产生的场强相比，其误差均小于1%。
- * 因此本程序采用将AB电偶极子剖分成100个首尾相连的小电偶极子的方式进行计算。
+ * Ex沿AB用自适应Gauss-Legendre求积计算，节点和容差见CalRhoThread::abRule及RHOSOLVER中的[Quadrature] Tol。
+ *
+ * 各站点之间互不相关，在线程池中并行计算：计算所需的坐标和频点数据先在GUI线程中
+ * 从数据库取好(RHO_JOB)，计算线程只做数值计算，不碰数据库；
+ * 算完一个站点就在GUI线程中发出SigRho画曲线，结果攒够一批写一次数据库。
  */
 #ifndef CALRHOTHREAD_H
 #define CALRHOTHREAD_H
 
-#include <QThread>
+#include <QObject>
 #include <QStringList>
 #include <QtMath>
 #include <QMessageBox>
 
 #include <complex>
+#include <algorithm>
+
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QCache>
+#include <QMap>
 
 #include "Common/PublicDef.h"
+#include "Common/RhoSolver.h"
+#include "Common/Quadrature.h"
+#include "Common/RhoTable.h"
 
 #include "MyDatabase.h"
 
@@ -36,13 +48,79 @@
 /* ε */
 #define EPSILON  (8.85*(pow(10, -12)))
 
-/* Split AB into 100 small electric dipoles. */
+/* Split AB into 100 small electric dipoles. 沿AB求积的容差设为0时使用 */
 #define NDIV    100
 
-/* Error */
-#define ERR     0.0005
+/* 沿AB自适应求积的默认相对容差，可在RHOSOLVER文件中修改 */
+#define RHO_QUAD_TOL        1e-6
+
+/* 定求积节点时考虑的最小电阻率(Ω·m)：ρ越小、频率越高，被积函数振荡越快 */
+#define RHO_QUAD_RHO_MIN    1.0
+
+/* 查表反演用的正演表最多占用的内存(KB)，超出时丢掉最久没用的站点 */
+#define RHO_TABLE_CACHE_KB  65536
+
+/* 一个站点各频点的正演表，表只在坐标、求积容差和定求积节点用的最高频率都不变时有效 */
+typedef struct _RHO_STATION_TABLE
+{
+    Position oAB;
+    Position oMN;
+
+    double dQuadTol;
+    double dFMax;
+
+    /* 频率 -> 表 */
+    QMap<double, RHO_TABLE> mapTable;
+}RHO_STATION_TABLE;
+
+/* 一个站点计算所需的全部输入 */
+typedef struct _RHO_JOB
+{
+    STATION oStation;
+
+    /* TX A&B, RX M&N coordinates */
+    Position oAB;
+    Position oMN;
+
+    SPECTRUM sSpectrum;
+
+    /* Ex/Eφ反演的容差和正演次数上限 */
+    SOLVER_OPT sOpt;
+
+    /* Ex沿AB求积的相对容差，<= 0 时按NDIV段 */
+    double dQuadTol;
+
+    /* Ex/Eφ查表反演，sTable为上次算这个站点时留下的表(可能为空) */
+    bool bTable;
+    RHO_STATION_TABLE sTable;
+}RHO_JOB;
+
+/* 一个站点的计算结果，以及补全后的正演表 */
+typedef struct _RHO_OUTPUT
+{
+    QList<RhoResult> aoRhoResult;
+
+    RHO_STATION_TABLE sTable;
+}RHO_OUTPUT;
+
+/* AB上各求积节点(小电偶极子)相对一个测点的几何量，只与坐标有关，每个站点算一次。
+ * 各数组一一对应，连续存放，供exSum逐项累加 */
+typedef struct _DIPOLE_GEOM
+{
+    /* 节点到测点的距离 r */
+    QVector<double> adR;
+
+    /* 1 - 3sin²φ，φ为节点-测点连线与AB的夹角 */
+    QVector<double> adA;
 
-class CalRhoThread : public QThread
+    /* w·L/(2π r³)，w为求积权；电流dI与频率有关，求和后再乘 */
+    QVector<double> adG;
+
+    /* 定节点时调用核函数的次数 */
+    int iEvals;
+}DIPOLE_GEOM;
+
+class CalRhoThread : public QObject
 {
     Q_OBJECT
 public:
@@ -54,31 +132,73 @@ public:
     /* TX A&B coordinates */
     Position oAB;
 
-    QPointF ptA;
-    QPointF ptB;
-    QPointF ptTxMid;
+    /* 反演的容差和正演次数上限、求积容差、是否查表，构造时从RHOSOLVER文件读取 */
+    SOLVER_OPT gsSolverOpt;
+    double gdQuadTol;
+    bool gbTable;
 
-    /* RX MN coordinates */
-    Position oMN;
+    /* 在线程池中并行计算这些站点，立即返回；算完一个发一次SigRho，全部算完(或取消)发SigFinished */
+    void CalRho(QList<STATION> aoStation);
 
-    QPointF ptM;
-    QPointF ptN;
-    QPointF ptRxMid;
+    bool getAB();
 
-    /* Calculate WFEM ρ in a Single thread for one MN */
-    void CalRho(STATION oStation);
+    /* 正在计算 */
+    bool isRunning();
 
-    bool getAB();
+    /* Calculate WFEM ρ for one MN. 只用sJob中的数据，可在任意线程中调用；
+     * psTable不为NULL时Ex/Eφ查表反演，缺的频点补建到psTable中 */
+    static QList<RhoResult> calStation(const RHO_JOB &sJob, RHO_STATION_TABLE *psTable = NULL);
 
-private:
-    /* Get coordinate from coordinate file */
-    bool CoorRead(STATION oStation);
+    /* 线程池中的任务：calStation，带回表 */
+    static RHO_OUTPUT runJob(const RHO_JOB &sJob);
+
+    /* 沿AB的求积节点：按站点的最高频率dFMax自适应，dTol <= 0 时为NDIV段中点公式 */
+    static QUAD_RULE abRule(const Position &oAB, const Position &oMN, double dFMax, double dTol);
+
+    /* 站点的小偶极子几何表 */
+    static DIPOLE_GEOM dipoleGeom(const Position &oAB, const Position &oMN, const QUAD_RULE &sRule);
+
+    /* Ex：Σ g(1 - 3sin²φ + e^(ikr) - ikr·e^(ikr))，不含电流dI */
+    static std::complex<double> exSum(const DIPOLE_GEOM &sGeom, std::complex<double> k);
+
+    /* Ex建表：一次算出iCnt个ρ的 ρ·|exSum| */
+    static void exTable(const DIPOLE_GEOM &sGeom, double dW, const double *pdRho, int iCnt, double *pdE);
 
     /* Angle between two lines */
-    double AngleGet(const QPointF ptPoint1, const QPointF ptPoint2, const QPointF ptPoint3, const QPointF ptPoint4);
+    static double AngleGet(const QPointF ptPoint1, const QPointF ptPoint2, const QPointF ptPoint3, const QPointF ptPoint4);
 
     /* The length  between two points */
-    double LengthGet(const QPointF ptPoint1, const QPointF ptPoint2);
+    static double LengthGet(const QPointF ptPoint1, const QPointF ptPoint2);
+
+private:
+    /* 在GUI线程中从数据库取出各站点的坐标和频点，取不到坐标的站点列在aoStrErr中 */
+    QList<RHO_JOB> prepare(QList<STATION> aoStation, QStringList &aoStrErr);
+
+    QFutureWatcher<RHO_OUTPUT> *poWatcher;
+
+    /* 已算完的站点数和总数 */
+    int giDone, giTotal;
+
+    /* 未收敛的频点数 */
+    int giFailed;
+
+    /* 核函数(单个小偶极子的场)调用总次数和已算完的频点数 */
+    qint64 giKernel;
+    int giPoints;
+
+    QElapsedTimer goTimer;
+
+    /* 各站点的正演表，只在GUI线程中读写 */
+    QCache<QString, RHO_STATION_TABLE> gocTable;
+
+    static QString tableKey(const STATION &oStation);
+
+    /* 还没写进数据库的结果，攒够DB_BATCH_ROWS行写一次 */
+    QList<RhoResult> gaoPending;
+
+    void flush();
+
+    double rate();
 
 signals:
     /* Error */
@@ -87,8 +207,20 @@ signals:
     /* Rho result struct */
     void SigRho(STATION, QVector<double>, QVector<double>);
 
+    /* 进度：已算完的站点数、总数、站点/秒 */
+    void SigProgress(int iDone, int iTotal, double dRate);
+
+    /* 全部算完或取消 */
+    void SigFinished(int iDone, int iTotal, double dRate);
+
 public slots:
+    /* 取消：还没开始的站点不再计算，已算完的照常保存 */
+    void cancel();
+
+private slots:
+    void resultReady(int iIndex);
 
+    void finished();
 };
 
 #endif // CALRHOTHREAD_H
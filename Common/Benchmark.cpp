@@ -0,0 +1,1684 @@
+#include "Common/Benchmark.h"
+
+#include "Data/RX.h"
+#include "Common/Stats.h"
+#include "Common/CsvReader.h"
+#include "MyDatabase.h"
+#include "CalRhoThread.h"
+
+#include <QTemporaryDir>
+
+#if defined(Q_OS_WIN) || defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/************************************************************************
+ * 原来的RX导入方式(QTextStream::readLine + QString::split + toDouble)，
+ * 仅作为对比基准保留在这里。
+ */
+static void legacyImportRX(QString oStrFileName, QMap<double, QVector<double> > &mapScatterList)
+{
+    QFile oFile(oStrFileName);
+
+    if(oFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream oStream(&oFile);
+
+        QStringList aoStrLineCSV;
+
+        QString oStrLineCSV;
+
+        while(!oStream.atEnd())
+        {
+            oStrLineCSV = oStream.readLine();
+
+            if(oStrLineCSV.isEmpty())
+            {
+                break;
+            }
+
+            aoStrLineCSV = oStrLineCSV.split(',', QString::SkipEmptyParts);
+
+            double dF = aoStrLineCSV.first().toDouble();
+
+            aoStrLineCSV.removeFirst();
+
+            QVector<double> adScatter;
+
+            foreach(QString oStrData, aoStrLineCSV)
+            {
+                adScatter.append(oStrData.toDouble());
+            }
+
+            mapScatterList.insert(dF, adScatter);
+        }
+    }
+
+    oFile.close();
+}
+
+/* 原RX::getAvg/RX::getErr(按值传参，getErr内再算一次平均值，逐个qPow) */
+static double legacyAvg(QVector<double> adData)
+{
+    double dAverage = 0;
+    double dSum = 0;
+
+    foreach(double dData, adData)
+    {
+        dSum += dData;
+    }
+
+    if(adData.count() != 0)
+    {
+        dAverage = dSum/adData.count();
+    }
+
+    return dAverage;
+}
+
+static double legacyErr(QVector<double> adData)
+{
+    double dAvg = legacyAvg(adData);
+
+    double dTemp = 0 ;
+
+    for(qint32 i = 0 ; i < adData.count(); i++)
+    {
+        dTemp += qPow((adData.at(i) - dAvg)/dAvg, 2);
+    }
+
+    return qSqrt(dTemp/adData.count()) * 100;
+}
+
+int Benchmark::run(QString oStrDir)
+{
+    QDir oDir(oStrDir);
+
+    if(!oDir.exists())
+    {
+        qDebugV5()<<"Benchmark dir not exist:"<<oStrDir;
+        return 1;
+    }
+
+    QStringList aoStrRX;
+
+    foreach(QFileInfo oFileInfo, oDir.entryInfoList(QStringList()<<"FFT_SEC_V_T*.csv", QDir::Files, QDir::Name))
+    {
+        aoStrRX.append(oFileInfo.absoluteFilePath());
+    }
+
+    qDebugV0()<<"Benchmark dir:"<<oDir.absolutePath()<<"RX files:"<<aoStrRX.count();
+
+    if(!aoStrRX.isEmpty())
+    {
+        benchImportRX(aoStrRX);
+
+        benchCacheRX(aoStrRX);
+    }
+
+    benchMemoryRX();
+
+    benchStats();
+
+    benchParseDouble();
+
+    benchInsertRX();
+
+    benchLookupRX();
+
+    benchStation();
+
+    benchModifyRho();
+
+    benchRhoStorage();
+
+    benchCalRho();
+
+    benchExSum();
+
+    benchRhoSolver();
+
+    benchQuadrature();
+
+    benchRhoTable();
+
+    return 0;
+}
+
+void Benchmark::benchImportRX(QStringList aoStrFile)
+{
+    QElapsedTimer oTimer;
+
+    /* 只比较文本解析，不走缓存 */
+    bool bUseCache = RX::gbUseCache;
+    RX::gbUseCache = false;
+
+    /* 先各跑一遍，让文件进入系统缓存，两种方式在同样条件下比较 */
+    qint64 iSamples = 0;
+    qint64 iBytes = 0;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        iBytes += QFileInfo(oStrFile).size();
+
+        RX oRX(oStrFile);
+
+        foreach(double dF, oRX.adF)
+        {
+            iSamples += oRX.scatter(dF).count();
+        }
+    }
+
+    /* 原解析方式 */
+    oTimer.start();
+
+    QList< QMap<double, QVector<double> > > aoLegacy;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        QMap<double, QVector<double> > mapScatterList;
+
+        legacyImportRX(oStrFile, mapScatterList);
+
+        aoLegacy.append(mapScatterList);
+    }
+
+    qint64 iLegacyMs = oTimer.elapsed();
+
+    /* 内存映射解析 */
+    oTimer.restart();
+
+    QList<RX *> apoRX;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        apoRX.append(new RX(oStrFile));
+    }
+
+    qint64 iMappedMs = oTimer.elapsed();
+
+    /* 两种方式结果逐个比对 */
+    int iMismatch = 0;
+
+    for(int i = 0; i < apoRX.count(); i++)
+    {
+        RX *poRX = apoRX.at(i);
+
+        bool bSame = (poRX->adF == aoLegacy.at(i).keys().toVector());
+
+        for(int j = 0; bSame && j < poRX->adF.count(); j++)
+        {
+            bSame = (poRX->scatter(poRX->adF.at(j)) == aoLegacy.at(i).value(poRX->adF.at(j)));
+        }
+
+        if(!bSame)
+        {
+            qDebugV5()<<"Mismatch:"<<aoStrFile.at(i);
+            iMismatch++;
+        }
+    }
+
+    qDeleteAll(apoRX);
+
+    qDebugV0()<<"ImportRX files:"<<aoStrFile.count()
+             <<"bytes:"<<iBytes
+            <<"samples:"<<iSamples;
+    qDebugV0()<<"ImportRX legacy(ms):"<<iLegacyMs
+             <<"mapped(ms):"<<iMappedMs
+            <<"speedup:"<<(iMappedMs > 0 ? (double)iLegacyMs/iMappedMs : 0)
+           <<"mismatch:"<<iMismatch;
+
+    RX::gbUseCache = bUseCache;
+}
+
+void Benchmark::benchCacheRX(QStringList aoStrFile)
+{
+    QElapsedTimer oTimer;
+
+    bool bUseCache = RX::gbUseCache;
+
+    /* 解析文本 */
+    RX::gbUseCache = false;
+
+    oTimer.start();
+
+    QList<RX *> apoText;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        apoText.append(new RX(oStrFile));
+    }
+
+    qint64 iTextMs = oTimer.elapsed();
+
+    /* 第一次打开：解析文本并写缓存 */
+    RX::gbUseCache = true;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        QFile::remove(oStrFile + ".rxc");
+    }
+
+    oTimer.restart();
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        delete new RX(oStrFile);
+    }
+
+    qint64 iWriteMs = oTimer.elapsed();
+
+    /* 再次打开：读缓存 */
+    oTimer.restart();
+
+    QList<RX *> apoCache;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        apoCache.append(new RX(oStrFile));
+    }
+
+    qint64 iCacheMs = oTimer.elapsed();
+
+    int iMismatch = 0;
+
+    for(int i = 0; i < apoText.count(); i++)
+    {
+        RX *poText  = apoText.at(i);
+        RX *poCache = apoCache.at(i);
+
+        bool bSame = (poText->adF == poCache->adF &&
+                      poText->adAvg == poCache->adAvg &&
+                      poText->adErr == poCache->adErr);
+
+        for(int j = 0; bSame && j < poText->adF.count(); j++)
+        {
+            bSame = (poText->scatter(poText->adF.at(j)) == poCache->scatter(poText->adF.at(j)));
+        }
+
+        if(!bSame)
+        {
+            qDebugV5()<<"Mismatch:"<<aoStrFile.at(i);
+            iMismatch++;
+        }
+    }
+
+    qDeleteAll(apoText);
+    qDeleteAll(apoCache);
+
+    qDebugV0()<<"CacheRX text(ms):"<<iTextMs
+             <<"text+write cache(ms):"<<iWriteMs
+            <<"cache(ms):"<<iCacheMs
+           <<"speedup:"<<(iCacheMs > 0 ? (double)iTextMs/iCacheMs : 0)
+          <<"mismatch:"<<iMismatch;
+
+    RX::gbUseCache = bUseCache;
+}
+
+/* 原来RX保存频点数据的方式：每个频点在4个QMap里各占一个节点 */
+typedef struct _LEGACY_RX
+{
+    QVector<double> adF;
+
+    QMap<double, QVector<double> > mapScatterList;
+    QMap<double, double> mapAvg;
+    QMap<double, double> mapErr;
+    QMap<double, QPair<qint64, qint64> > mapRowPos;
+}LEGACY_RX;
+
+/************************************************************************
+ * 堆上已分配未释放的字节数(不含malloc自身的头部)，前后两次相减即为其间新建对象的实际占用。
+ * Windows(mingw/msvcrt)逐块遍历CRT堆，glibc取mallinfo的统计(只含主线程的arena，基准在主线程中运行)；
+ * 其它平台返回-1。
+ */
+static qint64 heapInUse()
+{
+#if defined(Q_OS_WIN)
+    _HEAPINFO sInfo;
+    sInfo._pentry = NULL;
+
+    qint64 iBytes = 0;
+    int iStatus;
+
+    while((iStatus = _heapwalk(&sInfo)) == _HEAPOK)
+    {
+        if(sInfo._useflag == _USEDENTRY)
+        {
+            iBytes += sInfo._size;
+        }
+    }
+
+    return (iStatus == _HEAPEND) ? iBytes : -1;
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 sInfo = mallinfo2();
+
+    return (qint64)sInfo.uordblks + sInfo.hblkhd;
+#elif defined(__GLIBC__)
+    struct mallinfo sInfo = mallinfo();
+
+    return (qint64)(unsigned int)sInfo.uordblks + (unsigned int)sInfo.hblkhd;
+#else
+    return -1;
+#endif
+}
+
+void Benchmark::benchMemoryRX()
+{
+    const int iFCnt    = 1000;
+    const int iScatter = 5000;
+
+    QTemporaryDir oTmpDir;
+
+    if(!oTmpDir.isValid())
+    {
+        qDebugV5()<<"MemoryRX: can not create temp dir.";
+        return;
+    }
+
+    QString oStrFile = oTmpDir.path() + "/FFT_SEC_V_T(0)_L1_S1_D1_CH1_Ex.csv";
+
+    QFile oFile(oStrFile);
+
+    if(!oFile.open(QIODevice::WriteOnly))
+    {
+        qDebugV5()<<"MemoryRX: can not create"<<oStrFile;
+        return;
+    }
+
+    /* 合成数据：1000个频点，每个频点5000个散点 */
+    for(int i = 0; i < iFCnt; i++)
+    {
+        QByteArray aoLine = QByteArray::number(0.01*(i + 1), 'g', 10);
+
+        for(int j = 0; j < iScatter; j++)
+        {
+            aoLine.append(',');
+            aoLine.append(QByteArray::number(1.0 + 0.001*((i*31 + j*17)%1000), 'g', 10));
+        }
+
+        aoLine.append('\n');
+
+        oFile.write(aoLine);
+    }
+
+    oFile.close();
+
+    /* 同一文件按原来的QMap方式读入，量出常驻部分；读入时的临时字符串在量之前已释放 */
+    qint64 iHeap = heapInUse();
+
+    LEGACY_RX *psLegacy = new LEGACY_RX;
+
+    legacyImportRX(oStrFile, psLegacy->mapScatterList);
+
+    QMap<double, QVector<double> >::const_iterator it;
+
+    for(it = psLegacy->mapScatterList.constBegin(); it != psLegacy->mapScatterList.constEnd(); ++it)
+    {
+        psLegacy->adF.append(it.key());
+        psLegacy->mapAvg.insert(it.key(), legacyAvg(it.value()));
+        psLegacy->mapErr.insert(it.key(), legacyErr(it.value()));
+
+        /* 行位置的取值不影响占用 */
+        psLegacy->mapRowPos.insert(it.key(), qMakePair((qint64)0, (qint64)0));
+    }
+
+    qint64 iLegacy = heapInUse() - iHeap;
+
+    delete psLegacy;
+
+    /* 列式存储，不走二进制缓存，量法相同 */
+    bool bUseCache = RX::gbUseCache;
+    RX::gbUseCache = false;
+
+    iHeap = heapInUse();
+
+    RX *poRX = new RX(oStrFile);
+
+    qint64 iColumnar = heapInUse() - iHeap;
+
+    RX::gbUseCache = bUseCache;
+
+    qint64 iSamples = 0;
+
+    foreach(double dF, poRX->adF)
+    {
+        iSamples += poRX->scatter(dF).count();
+    }
+
+    qDebugV0()<<"MemoryRX freqs:"<<poRX->adF.count()
+             <<"samples:"<<iSamples;
+
+    if(iHeap < 0)
+    {
+        qDebugV0()<<"MemoryRX heap statistics not available on this platform, columnar(bytes, accounted):"
+                 <<poRX->memoryBytes();
+    }
+    else
+    {
+        /* legacy含全部散点，columnar不含读入后交给LRU缓存的散点，两者之比高估了节省的量 */
+        qDebugV0()<<"MemoryRX legacy map with scatter(bytes):"<<iLegacy
+                 <<"columnar without scatter(bytes):"<<iColumnar
+                <<"ratio:"<<(iColumnar > 0 ? (double)iLegacy/iColumnar : 0);
+    }
+
+    /* 散点按需读取，常驻的只有平均值、误差和索引，散点在LRU缓存中，不超过上限；
+     * 上面逐频点取过一遍散点，把缓存占用加上再比一次 */
+    qint64 iLru = RX::scatterCacheBytes();
+
+    qDebugV0()<<"MemoryRX scatter LRU(bytes):"<<iLru;
+
+    if(iHeap >= 0)
+    {
+        qDebugV0()<<"MemoryRX columnar + scatter LRU(bytes):"<<iColumnar + iLru
+                 <<"ratio:"<<(iColumnar + iLru > 0 ? (double)iLegacy/(iColumnar + iLru) : 0);
+    }
+
+    delete poRX;
+}
+
+void Benchmark::benchStats()
+{
+    const int iScatter = 5000;
+    const int iRepeat  = 2000;
+
+    /* 合成一组散点：平均值1附近的小幅波动，与实测场值量级相当 */
+    QVector<double> adScatter(iScatter);
+
+    for(int i = 0; i < iScatter; i++)
+    {
+        adScatter[i] = 1.0 + 0.001*((i*37)%1000) - 0.5e-3*((i*11)%7);
+    }
+
+    QElapsedTimer oTimer;
+
+    /* 原方式：getAvg + getErr，各自拷贝一次 */
+    oTimer.start();
+
+    double dLegacy = 0;
+
+    for(int i = 0; i < iRepeat; i++)
+    {
+        dLegacy += legacyAvg(adScatter) + legacyErr(adScatter);
+    }
+
+    qint64 iLegacyNs = oTimer.nsecsElapsed();
+
+    /* 统计模块：单次遍历 */
+    oTimer.restart();
+
+    double dStats = 0;
+
+    for(int i = 0; i < iRepeat; i++)
+    {
+        double dMean = 0, dErr = 0;
+
+        Stats::meanRelErr(adScatter.constData(), adScatter.count(), &dMean, &dErr);
+
+        dStats += dMean + dErr;
+    }
+
+    qint64 iStatsNs = oTimer.nsecsElapsed();
+
+    /* 中位数等需要排序的统计量，单独计时作参考 */
+    oTimer.restart();
+
+    double dRobust = 0;
+
+    for(int i = 0; i < iRepeat/10; i++)
+    {
+        dRobust += Stats::median(adScatter.constData(), adScatter.count()) +
+                Stats::mad(adScatter.constData(), adScatter.count()) +
+                Stats::trimmedMean(adScatter.constData(), adScatter.count(), 0.1);
+    }
+
+    qint64 iRobustNs = oTimer.nsecsElapsed();
+
+    qDebugV0()<<"Stats samples:"<<iScatter
+             <<"repeat:"<<iRepeat
+            <<"rel diff:"<<qAbs(dLegacy - dStats)/qAbs(dLegacy);
+    qDebugV0()<<"Stats legacy avg+err(us/call):"<<iLegacyNs/1000.0/iRepeat
+             <<"mean+relErr(us/call):"<<iStatsNs/1000.0/iRepeat
+            <<"speedup:"<<(iStatsNs > 0 ? (double)iLegacyNs/iStatsNs : 0);
+    qDebugV0()<<"Stats median+mad+trimmedMean(us/call):"<<iRobustNs/1000.0/(iRepeat/10)
+             <<"checksum:"<<dRobust;
+}
+
+void Benchmark::benchParseDouble()
+{
+    const int iCnt = 1000000;
+
+    /* 合成一行csv：实测文件中常见的定点和科学计数两种写法 */
+    QByteArray aoLine;
+
+    for(int i = 0; i < iCnt; i++)
+    {
+        if(i%2 == 0)
+        {
+            aoLine.append(QByteArray::number(1.0 + 1e-6*i, 'f', 9));
+        }
+        else
+        {
+            aoLine.append(QByteArray::number(-3.25e-5*i, 'e', 12));
+        }
+
+        aoLine.append(',');
+    }
+
+    QElapsedTimer oTimer;
+
+    /* 原方式：QString::split + toDouble */
+    oTimer.start();
+
+    QStringList aoStrField = QString::fromLatin1(aoLine).split(',', QString::SkipEmptyParts);
+
+    double dLegacy = 0;
+
+    foreach(QString oStrField, aoStrField)
+    {
+        dLegacy += oStrField.toDouble();
+    }
+
+    qint64 iLegacyMs = oTimer.elapsed();
+
+    /* CsvReader */
+    oTimer.restart();
+
+    CsvReader oReader(aoLine.constData(), aoLine.constData() + aoLine.size());
+
+    QVector<CSV_FIELD> aoField;
+
+    double dFast = 0;
+
+    while(oReader.readLine())
+    {
+        oReader.split(&aoField);
+
+        foreach(CSV_FIELD sField, aoField)
+        {
+            double dValue = 0;
+
+            CsvReader::toDouble(sField, &dValue);
+
+            dFast += dValue;
+        }
+    }
+
+    qint64 iFastMs = oTimer.elapsed();
+
+    qDebugV0()<<"ParseDouble values:"<<iCnt
+             <<"legacy(ms):"<<iLegacyMs
+            <<"CsvReader(ms):"<<iFastMs
+           <<"speedup:"<<(iFastMs > 0 ? (double)iLegacyMs/iFastMs : 0)
+          <<"diff:"<<qAbs(dLegacy - dFast);
+}
+
+/* 在临时库中建一张与MyDb.db相同结构的RX表，分别用两种方式各写入iRows行 */
+static qint64 insertRX(QString oStrDbFile, int iRows, bool bPrepared)
+{
+    QElapsedTimer oTimer;
+
+    {
+        QSqlDatabase oDb = QSqlDatabase::addDatabase("QSQLITE", "BenchInsertRX");
+
+        oDb.setDatabaseName(oStrDbFile);
+
+        if(!oDb.open())
+        {
+            qDebugV5()<<oDb.lastError().text();
+            return -1;
+        }
+
+        QSqlQuery oQuery(oDb);
+
+        oQuery.exec("DROP TABLE IF EXISTS RX");
+        oQuery.exec("CREATE TABLE RX(LineId TEXT, SiteId TEXT, DevId INTEGER, DevCh INTEGER, CompTag TEXT, "
+                    "F DOUBLE, I DOUBLE, Field DOUBLE, Err DOUBLE)");
+
+        oTimer.start();
+
+        if(bPrepared)
+        {
+            /* 与MyDatabase::importRX相同：整批攒成一个DB_WRITE，按写线程的方式执行 */
+            DB_WRITE sWrite;
+
+            sWrite.oStrSql = "INSERT INTO RX VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+            QVector<QVariantList> &aaoColumn = sWrite.aaoColumn;
+            aaoColumn.resize(9);
+
+            for(int i = 0; i < iRows; i++)
+            {
+                aaoColumn[0].append(QString::number(i/6000));
+                aaoColumn[1].append(QString::number(i/60));
+                aaoColumn[2].append(i%8);
+                aaoColumn[3].append(i%4);
+                aaoColumn[4].append(QString("Ex"));
+                aaoColumn[5].append(8192.0/(1 + i%60));
+                aaoColumn[6].append(10.0 + 1e-3*(i%97));
+                aaoColumn[7].append(1e-3*(1 + i%1000));
+                aaoColumn[8].append(0.01*(i%300));
+            }
+
+            QString oStrErr;
+
+            if(!DbWriter::execute(oDb, sWrite, &oStrErr))
+            {
+                qDebugV5()<<"InsertRX:"<<oStrErr;
+            }
+        }
+        else
+        {
+            oDb.transaction();
+
+            for(int i = 0; i < iRows; i++)
+            {
+                oQuery.exec(QString("INSERT INTO RX VALUES('%1', '%2', %3, %4, '%5', %6, %7, %8, %9)")
+                            .arg(i/6000)
+                            .arg(i/60)
+                            .arg(i%8)
+                            .arg(i%4)
+                            .arg("Ex")
+                            .arg(8192.0/(1 + i%60))
+                            .arg(10.0 + 1e-3*(i%97))
+                            .arg(1e-3*(1 + i%1000))
+                            .arg(0.01*(i%300)));
+            }
+
+            oDb.commit();
+        }
+
+        oDb.close();
+    }
+
+    QSqlDatabase::removeDatabase("BenchInsertRX");
+
+    return oTimer.elapsed();
+}
+
+void Benchmark::benchInsertRX()
+{
+    const int iRows = 1000000;
+
+    QTemporaryDir oTmpDir;
+
+    if(!oTmpDir.isValid())
+    {
+        qDebugV5()<<"InsertRX: can not create temp dir.";
+        return;
+    }
+
+    QString oStrDbFile = oTmpDir.path() + "/Bench.db";
+
+    qint64 iLegacyMs   = insertRX(oStrDbFile, iRows, false);
+    qint64 iPreparedMs = insertRX(oStrDbFile, iRows, true);
+
+    qDebugV0()<<"InsertRX rows:"<<iRows
+             <<"legacy(rows/s):"<<(iLegacyMs > 0 ? iRows*1000.0/iLegacyMs : 0)
+            <<"prepared batch(rows/s):"<<(iPreparedMs > 0 ? iRows*1000.0/iPreparedMs : 0)
+           <<"speedup:"<<(iPreparedMs > 0 ? (double)iLegacyMs/iPreparedMs : 0);
+}
+
+/* 建iStations个站点 x 60个频点的RX表，bKeyed时用MyDatabase::migrate建表，返回每次查询的耗时(us) */
+static double lookupRX(QString oStrDbFile, int iStations, bool bKeyed)
+{
+    const int iFCnt   = 60;
+    const int iLookup = 2000;
+
+    double dUs = -1;
+
+    QFile::remove(oStrDbFile);
+
+    {
+        QSqlDatabase oDb = QSqlDatabase::addDatabase("QSQLITE", "BenchLookupRX");
+
+        oDb.setDatabaseName(oStrDbFile);
+
+        if(!oDb.open())
+        {
+            qDebugV5()<<oDb.lastError().text();
+            return -1;
+        }
+
+        QSqlQuery oQuery(oDb);
+
+        if(bKeyed)
+        {
+            MyDatabase::migrate(oDb);
+        }
+        else
+        {
+            oQuery.exec("CREATE TABLE RX(LineId TEXT, SiteId TEXT, DevId INTEGER, DevCh INTEGER, CompTag TEXT, "
+                        "F DOUBLE, I DOUBLE, Field DOUBLE, Err DOUBLE)");
+        }
+
+        oDb.transaction();
+
+        oQuery.prepare("INSERT INTO RX VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+        QVector<QVariantList> aaoColumn(9);
+
+        for(int i = 0; i < iStations; i++)
+        {
+            for(int j = 0; j < iFCnt; j++)
+            {
+                aaoColumn[0].append(QString::number(i/100));
+                aaoColumn[1].append(QString::number(i%100));
+                aaoColumn[2].append(i%8);
+                aaoColumn[3].append(1);
+                aaoColumn[4].append(QString("Ex"));
+                aaoColumn[5].append(8192.0/(1 + j));
+                aaoColumn[6].append(10.0);
+                aaoColumn[7].append(1e-3*(1 + j));
+                aaoColumn[8].append(1.0);
+
+                if(aaoColumn.first().count() >= DB_BATCH_ROWS)
+                {
+                    MyDatabase::execBatch(oQuery, aaoColumn);
+                }
+            }
+        }
+
+        MyDatabase::execBatch(oQuery, aaoColumn);
+
+        oDb.commit();
+
+        /* 与MyDatabase::getField相同的查询 */
+        QElapsedTimer oTimer;
+        oTimer.start();
+
+        double dSum = 0;
+
+        for(int k = 0; k < iLookup; k++)
+        {
+            int i = (k*7919)%iStations;
+
+            oQuery.prepare("SELECT Field FROM RX WHERE "
+                           "LineId = ? AND SiteId = ? AND DevId = ? AND DevCh = ? AND F = ?");
+
+            oQuery.addBindValue(QString::number(i/100));
+            oQuery.addBindValue(QString::number(i%100));
+            oQuery.addBindValue(i%8);
+            oQuery.addBindValue(1);
+            oQuery.addBindValue(8192.0/(1 + k%iFCnt));
+
+            if(oQuery.exec() && oQuery.first())
+            {
+                dSum += oQuery.value(0).toDouble();
+            }
+        }
+
+        dUs = oTimer.nsecsElapsed()/1000.0/iLookup;
+
+        oQuery.finish();
+
+        oDb.close();
+    }
+
+    QSqlDatabase::removeDatabase("BenchLookupRX");
+
+    return dUs;
+}
+
+void Benchmark::benchLookupRX()
+{
+    QTemporaryDir oTmpDir;
+
+    if(!oTmpDir.isValid())
+    {
+        qDebugV5()<<"LookupRX: can not create temp dir.";
+        return;
+    }
+
+    QString oStrDbFile = oTmpDir.path() + "/Bench.db";
+
+    /* 200个站点是常见测区规模，再放大到看趋势 */
+    foreach(int iStations, QList<int>()<<200<<2000<<20000)
+    {
+        double dHeapUs  = lookupRX(oStrDbFile, iStations, false);
+        double dKeyedUs = lookupRX(oStrDbFile, iStations, true);
+
+        qDebugV0()<<"LookupRX rows:"<<iStations*60
+                 <<"heap(us/query):"<<dHeapUs
+                <<"keyed(us/query):"<<dKeyedUs
+               <<"speedup:"<<(dKeyedUs > 0 ? dHeapUs/dKeyedUs : 0);
+    }
+}
+
+void Benchmark::benchStation()
+{
+    const int iStations = 10000;
+    const int iFCnt     = 100;
+
+    QTemporaryDir oTmpDir;
+
+    if(!oTmpDir.isValid())
+    {
+        qDebugV5()<<"Station: can not create temp dir.";
+        return;
+    }
+
+    {
+        QSqlDatabase oDb = QSqlDatabase::addDatabase("QSQLITE", "BenchStation");
+
+        oDb.setDatabaseName(oTmpDir.path() + "/Bench.db");
+
+        if(!oDb.open() || !MyDatabase::migrate(oDb))
+        {
+            qDebugV5()<<oDb.lastError().text();
+            return;
+        }
+
+        {
+            QSqlQuery oQuery(oDb);
+
+            oDb.transaction();
+
+            oQuery.prepare("INSERT INTO RX VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+            QVector<QVariantList> aaoColumn(9);
+
+            for(int i = 0; i < iStations; i++)
+            {
+                for(int j = 0; j < iFCnt; j++)
+                {
+                    aaoColumn[0].append(QString::number(i/100));
+                    aaoColumn[1].append(QString::number(i%100));
+                    aaoColumn[2].append(i%8);
+                    aaoColumn[3].append(1);
+                    aaoColumn[4].append(QString("Ex"));
+                    aaoColumn[5].append(8192.0/(1 + j));
+                    aaoColumn[6].append(10.0);
+                    aaoColumn[7].append(1.0);
+                    aaoColumn[8].append(1.0);
+
+                    if(aaoColumn.first().count() >= DB_BATCH_ROWS)
+                    {
+                        MyDatabase::execBatch(oQuery, aaoColumn);
+                    }
+                }
+            }
+
+            MyDatabase::execBatch(oQuery, aaoColumn);
+
+            oDb.commit();
+        }
+
+        MyDatabase oMyDb;
+
+        oMyDb.poDb = &oDb;
+
+        QElapsedTimer oTimer;
+        oTimer.start();
+
+        int iFound = oMyDb.getStation("RX").count();
+
+        qDebugV0()<<"Station rows:"<<iStations*iFCnt
+                 <<"stations:"<<iFound
+                <<"getStation(ms):"<<oTimer.elapsed();
+
+        oDb.close();
+    }
+
+    QSqlDatabase::removeDatabase("BenchStation");
+}
+
+/* 选出Rho表并取完全部行，与界面上新建/刷新表格model的开销相当 */
+static void selectRho(CustomTableModel *poModel)
+{
+    poModel->select();
+
+    while(poModel->canFetchMore())
+    {
+        poModel->fetchMore();
+    }
+}
+
+void Benchmark::benchModifyRho()
+{
+    const int iCurves = 300;
+    const int iFCnt   = 40;
+
+    QTemporaryDir oTmpDir;
+
+    if(!oTmpDir.isValid())
+    {
+        qDebugV5()<<"ModifyRho: can not create temp dir.";
+        return;
+    }
+
+    {
+        QSqlDatabase oDb = QSqlDatabase::addDatabase("QSQLITE", "BenchRho");
+
+        oDb.setDatabaseName(oTmpDir.path() + "/Bench.db");
+
+        if(!oDb.open() || !MyDatabase::migrate(oDb))
+        {
+            qDebugV5()<<oDb.lastError().text();
+            return;
+        }
+
+        QList<STATION> aoStation;
+        QList<QPolygonF> aaoPointF;
+
+        {
+            QSqlQuery oQuery(oDb);
+
+            oDb.transaction();
+
+            oQuery.prepare("INSERT INTO Rho(LineId, SiteId, DevId, DevCh, CompTag, F, Rho) "
+                           "VALUES(?, ?, ?, ?, ?, ?, ?)");
+
+            QVector<QVariantList> aaoColumn(7);
+
+            for(int i = 0; i < iCurves; i++)
+            {
+                STATION oStation;
+                oStation.oStrLineId = QString::number(i/30);
+                oStation.oStrSiteId = QString::number(i%30);
+                oStation.iDevId = i;
+                oStation.iDevCh = 1;
+                oStation.oStrTag = "Ex";
+
+                QPolygonF aoPointF;
+
+                for(int j = 0; j < iFCnt; j++)
+                {
+                    double dF = 8192.0/(1 + j);
+
+                    aaoColumn[0].append(oStation.oStrLineId);
+                    aaoColumn[1].append(oStation.oStrSiteId);
+                    aaoColumn[2].append(oStation.iDevId);
+                    aaoColumn[3].append(oStation.iDevCh);
+                    aaoColumn[4].append(oStation.oStrTag);
+                    aaoColumn[5].append(dF);
+                    aaoColumn[6].append(100.0);
+
+                    aoPointF.append(QPointF(dF, 100.0 + j));
+                }
+
+                aoStation.append(oStation);
+                aaoPointF.append(aoPointF);
+            }
+
+            MyDatabase::execBatch(oQuery, aaoColumn);
+
+            oDb.commit();
+        }
+
+        QString oStrErr;
+
+        CustomTableModel *poModel = NULL;
+
+        /* 原方式：每条曲线一批逐点UPDATE，每批写完新建一个表格model */
+        QElapsedTimer oTimer;
+        oTimer.start();
+
+        for(int i = 0; i < iCurves; i++)
+        {
+            DB_WRITE sWrite;
+
+            sWrite.oStrSql = "UPDATE RhoData SET Rho = ? WHERE "
+                    "LineId = ? AND SiteId = ? AND DevId = ? AND DevCh = ? AND F = ?";
+
+            sWrite.aaoColumn.resize(6);
+
+            foreach(QPointF oPoint, aaoPointF.at(i))
+            {
+                sWrite.aaoColumn[0].append(oPoint.y());
+                sWrite.aaoColumn[1].append(aoStation.at(i).oStrLineId);
+                sWrite.aaoColumn[2].append(aoStation.at(i).oStrSiteId);
+                sWrite.aaoColumn[3].append(aoStation.at(i).iDevId);
+                sWrite.aaoColumn[4].append(aoStation.at(i).iDevCh);
+                sWrite.aaoColumn[5].append(oPoint.x());
+            }
+
+            DbWriter::execute(oDb, sWrite, &oStrErr);
+
+            delete poModel;
+
+            poModel = new CustomTableModel(NULL, oDb);
+            poModel->setTable("Rho");
+
+            selectRho(poModel);
+        }
+
+        qint64 iLegacyMs = oTimer.elapsed();
+
+        /* 临时表暂存，一条UPDATE，原model刷新一次 */
+        oTimer.restart();
+
+        /* 换一组值，写完能数出改到的行数 */
+        QList<QPolygonF> aaoBulk;
+
+        foreach(QPolygonF aoPointF, aaoPointF)
+        {
+            aaoBulk.append(aoPointF.translated(0, 1000));
+        }
+
+        DB_WRITE sWrite = MyDatabase::rhoUpdate(aoStation, aaoBulk);
+
+        bool bOk = DbWriter::execute(oDb, sWrite, &oStrErr);
+
+        selectRho(poModel);
+
+        qint64 iBulkMs = oTimer.elapsed();
+
+        delete poModel;
+
+        int iUpdated = 0;
+
+        {
+            QSqlQuery oQuery(oDb);
+
+            if(oQuery.exec("SELECT COUNT(*) FROM Rho WHERE Rho >= 1000") && oQuery.first())
+            {
+                iUpdated = oQuery.value(0).toInt();
+            }
+        }
+
+        qDebugV0()<<"ModifyRho curves:"<<iCurves<<"points:"<<iCurves*iFCnt
+                 <<"ok:"<<bOk<<"updated:"<<iUpdated<<oStrErr;
+        qDebugV0()<<"ModifyRho per-curve(ms):"<<iLegacyMs
+                 <<"bulk(ms):"<<iBulkMs
+                <<"speedup:"<<(iBulkMs > 0 ? (double)iLegacyMs/iBulkMs : 0);
+
+        oDb.close();
+    }
+
+    QSqlDatabase::removeDatabase("BenchRho");
+}
+
+/* 建iStations个站点 x iFCnt个频点的Rho，bWide时用原来带坐标的宽表，
+ * 返回数据库文件大小(字节)，piExportMs为按导出的方式读完全部22列的耗时 */
+static qint64 rhoStorage(QString oStrDbFile, int iStations, int iFCnt, bool bWide, qint64 *piExportMs)
+{
+    QString oStrConn = bWide ? "BenchRhoWide" : "BenchRhoView";
+
+    {
+        QSqlDatabase oDb = QSqlDatabase::addDatabase("QSQLITE", oStrConn);
+
+        oDb.setDatabaseName(oStrDbFile);
+
+        if(!oDb.open())
+        {
+            qDebugV5()<<oDb.lastError().text();
+            return 0;
+        }
+
+        QSqlQuery oQuery(oDb);
+
+        if(bWide)
+        {
+            /* 版本2的Rho表 */
+            oQuery.exec("CREATE TABLE Rho(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                        "DevId INTEGER NOT NULL, DevCh INTEGER NOT NULL, CompTag TEXT NOT NULL, "
+                        "F REAL NOT NULL, I REAL, Field REAL, Err REAL, Rho REAL, "
+                        "AX REAL, AY REAL, AH REAL, BX REAL, BY REAL, BH REAL, "
+                        "MX REAL, MY REAL, MH REAL, NX REAL, NY REAL, NH REAL, "
+                        "PRIMARY KEY(LineId, SiteId, DevId, DevCh, F, CompTag)) WITHOUT ROWID");
+        }
+        else
+        {
+            MyDatabase::migrate(oDb);
+        }
+
+        oDb.transaction();
+
+        /* 与MyDatabase::importRho相同的前22列，宽表没有诊断列 */
+        oQuery.prepare("INSERT OR REPLACE INTO Rho(LineId, SiteId, DevId, DevCh, CompTag, F, I, Field, Err, Rho, "
+                       "AX, AY, AH, BX, BY, BH, MX, MY, MH, NX, NY, NH) "
+                       "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+        QVector<QVariantList> aaoColumn(22);
+
+        for(int i = 0; i < iStations; i++)
+        {
+            for(int j = 0; j < iFCnt; j++)
+            {
+                aaoColumn[0].append(QString::number(i/30));
+                aaoColumn[1].append(QString::number(i%30));
+                aaoColumn[2].append(i);
+                aaoColumn[3].append(1);
+                aaoColumn[4].append(QString("Ex"));
+                aaoColumn[5].append(8192.0/(1 + j));
+                aaoColumn[6].append(10.0 + j*0.1);
+                aaoColumn[7].append(0.123456789*(j + 1));
+                aaoColumn[8].append(1.23456789);
+                aaoColumn[9].append(100.0 + j);
+
+                for(int k = 10; k < 22; k++)
+                {
+                    aaoColumn[k].append(3456789.123 + i*50.0 + k);
+                }
+
+                if(aaoColumn.first().count() >= DB_BATCH_ROWS)
+                {
+                    MyDatabase::execBatch(oQuery, aaoColumn);
+                }
+            }
+        }
+
+        MyDatabase::execBatch(oQuery, aaoColumn);
+
+        oDb.commit();
+
+        oQuery.exec("VACUUM");
+
+        /* 导出：全部行、全部22列转成文本 */
+        QElapsedTimer oTimer;
+        oTimer.start();
+
+        qint64 iChars = 0;
+
+        oQuery.setForwardOnly(true);
+
+        if(oQuery.exec("SELECT * FROM Rho"))
+        {
+            while(oQuery.next())
+            {
+                for(int k = 0; k < 22; k++)
+                {
+                    iChars += oQuery.value(k).toString().length();
+                }
+            }
+        }
+
+        *piExportMs = oTimer.elapsed();
+
+        qDebugV0()<<(bWide ? "wide" : "view")<<"export chars:"<<iChars;
+
+        oQuery.finish();
+
+        oDb.close();
+    }
+
+    QSqlDatabase::removeDatabase(oStrConn);
+
+    return QFileInfo(oStrDbFile).size();
+}
+
+void Benchmark::benchRhoStorage()
+{
+    const int iStations = 3000;
+    const int iFCnt     = 40;
+
+    QTemporaryDir oTmpDir;
+
+    if(!oTmpDir.isValid())
+    {
+        qDebugV5()<<"RhoStorage: can not create temp dir.";
+        return;
+    }
+
+    qint64 iWideMs = 0, iViewMs = 0;
+
+    qint64 iWideBytes = rhoStorage(oTmpDir.path() + "/Wide.db", iStations, iFCnt, true,  &iWideMs);
+    qint64 iViewBytes = rhoStorage(oTmpDir.path() + "/View.db", iStations, iFCnt, false, &iViewMs);
+
+    qDebugV0()<<"RhoStorage stations:"<<iStations<<"rows:"<<iStations*iFCnt;
+    qDebugV0()<<"RhoStorage wide(bytes):"<<iWideBytes
+             <<"normalized(bytes):"<<iViewBytes
+            <<"ratio:"<<(iViewBytes > 0 ? (double)iWideBytes/iViewBytes : 0);
+    qDebugV0()<<"RhoStorage export wide(ms):"<<iWideMs
+             <<"normalized(ms):"<<iViewMs;
+}
+
+/* AB沿x轴长1km，测点在AB中垂线两侧散开，每个站点40个频点 */
+static QList<RHO_JOB> rhoJobs(int iStations)
+{
+    QList<RHO_JOB> aoJob;
+
+    for(int i = 0; i < iStations; i++)
+    {
+        RHO_JOB sJob;
+
+        sJob.oStation.oStrLineId = QString::number(i/100);
+        sJob.oStation.oStrSiteId = QString::number(i%100);
+        sJob.oStation.iDevId = i;
+        sJob.oStation.iDevCh = 1;
+        sJob.oStation.oStrTag = "Ex";
+
+        Position oAB = { 0, 0, 0, 1000, 0, 0 };
+        sJob.oAB = oAB;
+
+        double dX = 500 + (i%100 - 50)*40.0;
+        double dY = 5000 + (i/100)*100.0;
+
+        Position oMN = { dX - 50, dY, 0, dX + 50, dY, 0 };
+        sJob.oMN = oMN;
+
+        for(int j = 0; j < 40; j++)
+        {
+            sJob.sSpectrum.adF.append(8192.0/(1 << (j/4)) / (1 + j%4));
+            sJob.sSpectrum.adI.append(50.0);
+            sJob.sSpectrum.adField.append(0.5/(1 + j));
+            sJob.sSpectrum.adErr.append(1.0);
+        }
+
+        sJob.sOpt = RhoSolver::defaultOpt();
+        sJob.dQuadTol = RHO_QUAD_TOL;
+        sJob.bTable = false;
+
+        aoJob.append(sJob);
+    }
+
+    return aoJob;
+}
+
+void Benchmark::benchCalRho()
+{
+    const int iStations = 500;
+
+    QList<RHO_JOB> aoJob = rhoJobs(iStations);
+
+    QElapsedTimer oTimer;
+    oTimer.start();
+
+    QList< QList<RhoResult> > aaoSerial;
+
+    foreach(RHO_JOB sJob, aoJob)
+    {
+        aaoSerial.append(CalRhoThread::calStation(sJob));
+    }
+
+    qint64 iSerialMs = oTimer.elapsed();
+
+    oTimer.restart();
+
+    /* 与CalRhoThread::CalRho相同的任务函数 */
+    QList<RHO_OUTPUT> aoParallel = QtConcurrent::blockingMapped(aoJob, CalRhoThread::runJob);
+
+    qint64 iParallelMs = oTimer.elapsed();
+
+    int iMismatch = 0;
+
+    for(int i = 0; i < aaoSerial.count(); i++)
+    {
+        for(int j = 0; j < aaoSerial.at(i).count(); j++)
+        {
+            if(aaoSerial.at(i).at(j).dRho != aoParallel.at(i).aoRhoResult.at(j).dRho)
+            {
+                iMismatch++;
+            }
+        }
+    }
+
+    qDebugV0()<<"CalRho stations:"<<iStations<<"threads:"<<QThread::idealThreadCount()
+             <<"mismatch:"<<iMismatch;
+    qDebugV0()<<"CalRho serial(ms):"<<iSerialMs
+             <<"parallel(ms):"<<iParallelMs
+            <<"stations/s:"<<(iSerialMs > 0 ? iStations*1000.0/iSerialMs : 0)
+           <<"->"<<(iParallelMs > 0 ? iStations*1000.0/iParallelMs : 0);
+}
+
+/* 原Ex计算：每次迭代、每个频点都逐个小偶极子重算中点、r、φ、r³和k */
+static QVector<double> legacyEx(const RHO_JOB &sJob)
+{
+    QPointF ptA(sJob.oAB.dMX, sJob.oAB.dMY);
+    QPointF ptB(sJob.oAB.dNX, sJob.oAB.dNY);
+
+    QPointF ptM(sJob.oMN.dMX, sJob.oMN.dMY);
+    QPointF ptN(sJob.oMN.dNX, sJob.oMN.dNY);
+    QPointF ptRxMid( (ptM.x() + ptN.x())/2, (ptM.y() + ptN.y())/2 );
+
+    double dL  = CalRhoThread::LengthGet(ptA, ptB)/NDIV;
+    double dMN = CalRhoThread::LengthGet(ptM, ptN);
+
+    std::complex<double> IMAGE(0, 1);
+
+    QVector<double> adRho;
+
+    for(int i = 0; i < sJob.sSpectrum.adF.count(); i++)
+    {
+        double dI = sJob.sSpectrum.adI.at(i);
+        double dE = ( sJob.sSpectrum.adField.at(i)*UU )/dMN;
+        double dW = sJob.sSpectrum.adF.at(i)*2*M_PI;
+
+        double dRho0 = 10;
+        double dRho  = 100;
+
+        while( qAbs( (dRho - dRho0)/dRho0 ) >= RHO_TOL )
+        {
+            dRho0 = dRho;
+
+            std::complex<double> cca(0, 0);
+
+            for(qint32 j = 1; j < NDIV +1; j++)
+            {
+                QPointF ptDipoleMid( ptA.x() + (ptB.x() - ptA.x())/2/NDIV*(2*j-1),
+                                     ptA.y() + (ptB.y() - ptA.y())/2/NDIV*(2*j-1));
+
+                double dR = CalRhoThread::LengthGet(ptDipoleMid, ptRxMid);
+
+                double dPhi = CalRhoThread::AngleGet(ptA, ptB, ptRxMid, ptDipoleMid);
+
+                double dCc = (dI*dL)/(2*M_PI*(pow(dR, 3)));
+
+                std::complex<double> k2( EPSILON*MU*pow(dW, 2), dW*MU/dRho0 );
+
+                std::complex<double> k = sqrt(k2);
+
+                cca = cca + dCc*(1-3*sin(dPhi)*sin(dPhi)+exp(IMAGE*k*dR)- IMAGE*k*dR*exp(IMAGE*k*dR));
+            }
+
+            dRho = abs(dE/cca);
+        }
+
+        adRho.append(dRho);
+    }
+
+    return adRho;
+}
+
+void Benchmark::benchExSum()
+{
+    const int iStations = 200;
+
+    QList<RHO_JOB> aoJob = rhoJobs(iStations);
+
+    /* 与原来一样按NDIV段 */
+    for(int i = 0; i < aoJob.count(); i++)
+    {
+        aoJob[i].dQuadTol = 0;
+    }
+
+    QElapsedTimer oTimer;
+    oTimer.start();
+
+    QList< QVector<double> > aadLegacy;
+
+    foreach(RHO_JOB sJob, aoJob)
+    {
+        aadLegacy.append(legacyEx(sJob));
+    }
+
+    qint64 iLegacyMs = oTimer.elapsed();
+
+    oTimer.restart();
+
+    QList< QList<RhoResult> > aaoTable;
+
+    foreach(RHO_JOB sJob, aoJob)
+    {
+        aaoTable.append(CalRhoThread::calStation(sJob));
+    }
+
+    qint64 iTableMs = oTimer.elapsed();
+
+    double dMaxRelDiff = 0;
+
+    for(int i = 0; i < aadLegacy.count(); i++)
+    {
+        for(int j = 0; j < aadLegacy.at(i).count(); j++)
+        {
+            double dRef = aadLegacy.at(i).at(j);
+
+            dMaxRelDiff = qMax(dMaxRelDiff, qAbs(aaoTable.at(i).at(j).dRho - dRef)/dRef);
+        }
+    }
+
+    qDebugV0()<<"ExSum stations:"<<iStations<<"legacy(ms):"<<iLegacyMs
+             <<"table(ms):"<<iTableMs
+            <<"speedup:"<<(iTableMs > 0 ? double(iLegacyMs)/iTableMs : 0)
+           <<"max rel diff:"<<dMaxRelDiff;
+}
+
+/* 按rhoJobs的几何，用给定的真值ρ正演出场值，再分别用两种方法反演 */
+void Benchmark::benchRhoSolver()
+{
+    const int iStations = 200;
+
+    QList<RHO_JOB> aoJob = rhoJobs(iStations);
+
+    SOLVER_OPT sOpt = RhoSolver::defaultOpt();
+
+    /* 不动点迭代原来没有上限，这里放宽，看它实际要多少次 */
+    SOLVER_OPT sFixedOpt = sOpt;
+    sFixedOpt.iMaxIter = 1000;
+
+    const double adTrueRho[4] = { 10, 100, 1000, 5000 };
+
+    qint64 iFixedIter = 0, iSolveIter = 0;
+    int iFixedFailed = 0, iSolveFailed = 0, iPoints = 0;
+    double dMaxRelErr = 0;
+
+    qint64 iFixedNs = 0, iSolveNs = 0;
+
+    QElapsedTimer oTimer;
+
+    for(int i = 0; i < aoJob.count(); i++)
+    {
+        const RHO_JOB &sJob = aoJob.at(i);
+
+        DIPOLE_GEOM sGeom = CalRhoThread::dipoleGeom(sJob.oAB, sJob.oMN, Quadrature::midpoint(NDIV));
+
+        for(int j = 0; j < sJob.sSpectrum.adF.count(); j++)
+        {
+            double dW = sJob.sSpectrum.adF.at(j)*2*M_PI;
+            double dI = sJob.sSpectrum.adI.at(j);
+
+            std::function<double(double)> oForward = [&](double dRho) -> double
+            {
+                std::complex<double> k = sqrt(std::complex<double>(EPSILON*MU*pow(dW, 2), dW*MU/dRho));
+
+                return dRho*abs(dI*CalRhoThread::exSum(sGeom, k));
+            };
+
+            double dTrueRho = adTrueRho[(i + j)%4];
+
+            double dE = oForward(dTrueRho);
+
+            oTimer.start();
+            SOLVER_RESULT sFixed = RhoSolver::fixedPoint(oForward, dE, 100, sFixedOpt);
+            iFixedNs += oTimer.nsecsElapsed();
+
+            oTimer.start();
+            SOLVER_RESULT sSolve = RhoSolver::solve(oForward, dE, 100, sOpt);
+            iSolveNs += oTimer.nsecsElapsed();
+
+            iFixedIter += sFixed.iIter;
+            iSolveIter += sSolve.iIter;
+
+            iFixedFailed += sFixed.bConverged ? 0 : 1;
+            iSolveFailed += sSolve.bConverged ? 0 : 1;
+
+            dMaxRelErr = qMax(dMaxRelErr, qAbs(sSolve.dRho - dTrueRho)/dTrueRho);
+
+            iPoints++;
+        }
+    }
+
+    qDebugV0()<<"RhoSolver points:"<<iPoints
+             <<"fixed point evals/pt:"<<double(iFixedIter)/iPoints<<"not converged:"<<iFixedFailed
+            <<"(ms):"<<iFixedNs/1000000;
+    qDebugV0()<<"RhoSolver secant evals/pt:"<<double(iSolveIter)/iPoints<<"not converged:"<<iSolveFailed
+             <<"(ms):"<<iSolveNs/1000000
+            <<"max rel err:"<<dMaxRelErr;
+}
+
+/* AB长1km，测点在AB中垂线上，收发距从0.05km到20km；
+ * 场值以20000段中点公式为准，比较NDIV段和自适应求积的误差、节点数 */
+void Benchmark::benchQuadrature()
+{
+    Position oAB = { 0, 0, 0, 1000, 0, 0 };
+
+    const double adOffset[7] = { 50, 200, 500, 1000, 3000, 8000, 20000 };
+    const double adF[3] = { 8192, 64, 0.5 };
+
+    QUAD_RULE sRef = Quadrature::midpoint(20000);
+    QUAD_RULE sDiv = Quadrature::midpoint(NDIV);
+
+    for(int i = 0; i < 7; i++)
+    {
+        Position oMN = { 450, adOffset[i], 0, 550, adOffset[i], 0 };
+
+        QUAD_RULE sQuad = CalRhoThread::abRule(oAB, oMN, adF[0], RHO_QUAD_TOL);
+
+        DIPOLE_GEOM sGeomRef  = CalRhoThread::dipoleGeom(oAB, oMN, sRef);
+        DIPOLE_GEOM sGeomDiv  = CalRhoThread::dipoleGeom(oAB, oMN, sDiv);
+        DIPOLE_GEOM sGeomQuad = CalRhoThread::dipoleGeom(oAB, oMN, sQuad);
+
+        double dErrDiv = 0, dErrQuad = 0;
+
+        for(int j = 0; j < 3; j++)
+        {
+            double dW = adF[j]*2*M_PI;
+
+            std::complex<double> k = sqrt(std::complex<double>(EPSILON*MU*pow(dW, 2), dW*MU/100));
+
+            std::complex<double> cRef = CalRhoThread::exSum(sGeomRef, k);
+
+            dErrDiv  = qMax(dErrDiv, std::abs(CalRhoThread::exSum(sGeomDiv, k)/cRef - 1.0));
+            dErrQuad = qMax(dErrQuad, std::abs(CalRhoThread::exSum(sGeomQuad, k)/cRef - 1.0));
+        }
+
+        qDebugV0()<<"Quadrature offset(m):"<<adOffset[i]
+                 <<"NDIV nodes:"<<NDIV<<"rel err:"<<dErrDiv
+                <<"adaptive nodes:"<<sQuad.adT.count()<<"build evals:"<<sQuad.iEvals<<"rel err:"<<dErrQuad;
+    }
+
+    /* 整条测线：NDIV段 vs 自适应求积算出的ρ */
+    QList<RHO_JOB> aoJob = rhoJobs(200);
+
+    double dMaxRelDiff = 0;
+    qint64 iKernelDiv = 0, iKernelQuad = 0;
+    qint64 iDivMs = 0, iQuadMs = 0;
+
+    QElapsedTimer oTimer;
+
+    foreach(RHO_JOB sJob, aoJob)
+    {
+        sJob.dQuadTol = 0;
+
+        oTimer.start();
+        QList<RhoResult> aoDiv = CalRhoThread::calStation(sJob);
+        iDivMs += oTimer.elapsed();
+
+        sJob.dQuadTol = RHO_QUAD_TOL;
+
+        oTimer.start();
+        QList<RhoResult> aoQuad = CalRhoThread::calStation(sJob);
+        iQuadMs += oTimer.elapsed();
+
+        for(int j = 0; j < aoDiv.count(); j++)
+        {
+            dMaxRelDiff = qMax(dMaxRelDiff, qAbs(aoQuad.at(j).dRho/aoDiv.at(j).dRho - 1));
+
+            iKernelDiv  += aoDiv.at(j).iKernel;
+            iKernelQuad += aoQuad.at(j).iKernel;
+        }
+    }
+
+    qDebugV0()<<"Quadrature line kernel evals NDIV:"<<iKernelDiv<<"(ms):"<<iDivMs
+             <<"adaptive:"<<iKernelQuad<<"(ms):"<<iQuadMs
+            <<"max rho rel diff:"<<dMaxRelDiff;
+}
+
+/* 200个站点的测线：逐点迭代 vs 查表(首次建表、改场值后重算) */
+void Benchmark::benchRhoTable()
+{
+    const int iStations = 200;
+
+    QList<RHO_JOB> aoJob = rhoJobs(iStations);
+
+    QElapsedTimer oTimer;
+
+    /* 逐点迭代 */
+    QList< QList<RhoResult> > aaoSolve;
+    qint64 iSolveKernel = 0;
+
+    oTimer.start();
+
+    foreach(RHO_JOB sJob, aoJob)
+    {
+        aaoSolve.append(CalRhoThread::calStation(sJob));
+    }
+
+    qint64 iSolveMs = oTimer.elapsed();
+
+    /* 首次：建表 */
+    QList<RHO_STATION_TABLE> aoTable;
+    qint64 iBuildKernel = 0;
+
+    oTimer.start();
+
+    foreach(RHO_JOB sJob, aoJob)
+    {
+        RHO_STATION_TABLE sTable;
+
+        QList<RhoResult> aoRho = CalRhoThread::calStation(sJob, &sTable);
+
+        foreach(RhoResult oRho, aoRho)
+        {
+            iBuildKernel += oRho.iKernel;
+        }
+
+        aoTable.append(sTable);
+    }
+
+    qint64 iBuildMs = oTimer.elapsed();
+
+    /* 改场值(全部乘1.1)后重算：两种方法各一遍 */
+    for(int i = 0; i < aoJob.count(); i++)
+    {
+        QVector<double> &adField = aoJob[i].sSpectrum.adField;
+
+        for(int j = 0; j < adField.count(); j++)
+        {
+            adField[j] *= 1.1;
+        }
+    }
+
+    aaoSolve.clear();
+
+    oTimer.start();
+
+    foreach(RHO_JOB sJob, aoJob)
+    {
+        aaoSolve.append(CalRhoThread::calStation(sJob));
+    }
+
+    qint64 iResolveMs = oTimer.elapsed();
+
+    foreach(QList<RhoResult> aoRho, aaoSolve)
+    {
+        foreach(RhoResult oRho, aoRho)
+        {
+            iSolveKernel += oRho.iKernel;
+        }
+    }
+
+    qint64 iLookupKernel = 0;
+    int iFailed = 0;
+    double dMaxRelDiff = 0;
+
+    oTimer.start();
+
+    QList< QList<RhoResult> > aaoLookup;
+
+    for(int i = 0; i < aoJob.count(); i++)
+    {
+        aaoLookup.append(CalRhoThread::calStation(aoJob.at(i), &aoTable[i]));
+    }
+
+    qint64 iLookupMs = oTimer.elapsed();
+
+    for(int i = 0; i < aaoLookup.count(); i++)
+    {
+        for(int j = 0; j < aaoLookup.at(i).count(); j++)
+        {
+            const RhoResult &oRho = aaoLookup.at(i).at(j);
+
+            iLookupKernel += oRho.iKernel;
+            iFailed += oRho.bConverged ? 0 : 1;
+
+            dMaxRelDiff = qMax(dMaxRelDiff, qAbs(oRho.dRho/aaoSolve.at(i).at(j).dRho - 1));
+        }
+    }
+
+    qDebugV0()<<"RhoTable stations:"<<iStations<<"solve(ms):"<<iSolveMs<<"build table(ms):"<<iBuildMs
+             <<"kernel evals:"<<iBuildKernel;
+    qDebugV0()<<"RhoTable after field edit, solve(ms):"<<iResolveMs<<"kernel evals:"<<iSolveKernel
+             <<"lookup(ms):"<<iLookupMs<<"kernel evals:"<<iLookupKernel
+            <<"not converged:"<<iFailed<<"max rel diff:"<<dMaxRelDiff;
+}
@@ -0,0 +1,70 @@
+/**********************************************************************
+ * 性能测试
+ *
+ * 用法：DataPreprocess --bench <数据目录>
+ * 对目录下的实测文件运行各项对比测试，结果输出到调试信息，不启动主界面。
+ */
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QDir>
+
+#include "Common/PublicDef.h"
+
+class Benchmark
+{
+public:
+    /* 运行全部测试，返回值作为程序退出码 */
+    static int run(QString oStrDir);
+
+private:
+    /* RX导入：原QTextStream/QStringList逐行解析 vs 内存映射字节解析 */
+    static void benchImportRX(QStringList aoStrFile);
+
+    /* RX导入：解析文本 vs 读二进制缓存 */
+    static void benchCacheRX(QStringList aoStrFile);
+
+    /* RX内存占用：原QMap逐频点存储 vs 列式数组，合成数据，按堆的实际分配量出。
+     * 原方式常驻全部散点，列式只常驻平均值、误差和索引，散点交给LRU缓存，不计入列式的数字 */
+    static void benchMemoryRX();
+
+    /* 统计：原RX::getAvg/getErr vs Stats单次遍历 */
+    static void benchStats();
+
+    /* 数值解析：QString::split + toDouble vs CsvReader */
+    static void benchParseDouble();
+
+    /* 数据库写入：QString::arg拼接INSERT vs 预编译语句批量绑定，合成1M行RX表 */
+    static void benchInsertRX();
+
+    /* 数据库查询：原无键堆表 vs 迁移后的主键表，按站点+频点查场值，随表大小变化 */
+    static void benchLookupRX();
+
+    /* 站点枚举：MyDatabase::getStation，10k个站点 x 100个频点 */
+    static void benchStation();
+
+    /* 保存手动修改的Rho：逐曲线UPDATE并重建model vs 临时表一次UPDATE、model刷新一次，300条曲线 */
+    static void benchModifyRho();
+
+    /* Rho存储：每行带12列坐标的宽表 vs 坐标按站点存一次(RhoStation + RhoData + 视图)，比较文件大小和导出 */
+    static void benchRhoStorage();
+
+    /* 视电阻率计算：逐站点串行 vs 线程池并行，合成的Ex站点 */
+    static void benchCalRho();
+
+    /* Ex求和：每次迭代逐个小偶极子重算几何量 vs 站点几何表 + 实数累加，200个站点的测线 */
+    static void benchExSum();
+
+    /* Ex反演：原不动点迭代 vs 割线法，比较正演次数和未收敛的频点数 */
+    static void benchRhoSolver();
+
+    /* 沿AB求积：NDIV段中点公式 vs 自适应Gauss-Legendre，不同收发距下的误差和节点数 */
+    static void benchQuadrature();
+
+    /* 查表反演：逐点迭代 vs 建表、改场值后查表重算，200个站点的测线 */
+    static void benchRhoTable();
+};
+
+#endif // BENCHMARK_H
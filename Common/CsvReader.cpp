@@ -0,0 +1,288 @@
+#include "Common/CsvReader.h"
+
+#include <cstring>
+
+/* 记下的错误条数上限，超过的只计数 */
+#define CSV_MAX_ERR     100
+
+CsvReader::CsvReader(const char *pcBegin, const char *pcEnd, qint64 iBase, qint64 iFirstLineNo)
+{
+    gpcBegin = pcBegin;
+    gpcEnd   = pcEnd;
+
+    gpcNext = pcBegin;
+
+    /* UTF-8 BOM */
+    if(iBase == 0 && pcEnd - pcBegin >= 3 &&
+            (uchar)pcBegin[0] == 0xEF && (uchar)pcBegin[1] == 0xBB && (uchar)pcBegin[2] == 0xBF)
+    {
+        gpcNext += 3;
+    }
+
+    gpcLine    = gpcNext;
+    gpcLineEnd = gpcNext;
+
+    gbLineEol = false;
+
+    giBase = iBase;
+
+    /* 行号在readLine里先加1；未知时为-1，不再计数 */
+    giLineNo = (iFirstLineNo > 0) ? iFirstLineNo - 1 : -1;
+
+    giErrCnt = 0;
+}
+
+bool CsvReader::readLine(bool bWaitEol)
+{
+    if(gpcNext >= gpcEnd)
+    {
+        return false;
+    }
+
+    const char *pcEol = (const char *)memchr(gpcNext, '\n', gpcEnd - gpcNext);
+
+    if(pcEol == NULL && bWaitEol)
+    {
+        return false;
+    }
+
+    gbLineEol = (pcEol != NULL);
+
+    if(pcEol == NULL)
+    {
+        pcEol = gpcEnd;
+    }
+
+    gpcLine    = gpcNext;
+    gpcLineEnd = pcEol;
+
+    if(gpcLineEnd > gpcLine && *(gpcLineEnd - 1) == '\r')
+    {
+        gpcLineEnd--;
+    }
+
+    gpcNext = gbLineEol ? pcEol + 1 : gpcEnd;
+
+    if(giLineNo >= 0)
+    {
+        giLineNo++;
+    }
+
+    return true;
+}
+
+int CsvReader::split(QVector<CSV_FIELD> *paoField, bool bSkipEmpty) const
+{
+    paoField->resize(0);
+
+    const char *pcField = gpcLine;
+
+    while(pcField <= gpcLineEnd)
+    {
+        const char *pcComma = (const char *)memchr(pcField, ',', gpcLineEnd - pcField);
+
+        if(pcComma == NULL)
+        {
+            pcComma = gpcLineEnd;
+        }
+
+        if(!bSkipEmpty || pcComma != pcField)
+        {
+            CSV_FIELD sField;
+            sField.pcBegin = pcField;
+            sField.pcEnd   = pcComma;
+
+            paoField->append(sField);
+        }
+
+        pcField = pcComma + 1;
+    }
+
+    return paoField->count();
+}
+
+void CsvReader::error(QString oStrMsg)
+{
+    giErrCnt++;
+
+    if(gaoStrErr.count() >= CSV_MAX_ERR)
+    {
+        return;
+    }
+
+    if(giLineNo > 0)
+    {
+        gaoStrErr.append(QString("第%1行：%2").arg(giLineNo).arg(oStrMsg));
+    }
+    else
+    {
+        gaoStrErr.append(QString("偏移%1：%2").arg(this->lineOffset()).arg(oStrMsg));
+    }
+}
+
+bool CsvReader::toInt(const CSV_FIELD &sField, int *piValue)
+{
+    bool bOk = false;
+
+    *piValue = QByteArray::fromRawData(sField.pcBegin, sField.pcEnd - sField.pcBegin).trimmed().toInt(&bOk);
+
+    return bOk;
+}
+
+QString CsvReader::toString(const CSV_FIELD &sField)
+{
+    return QString::fromLocal8Bit(sField.pcBegin, sField.pcEnd - sField.pcBegin).trimmed();
+}
+
+/************************************************************************
+ * 与语言环境无关的浮点数解析
+ * 常见的 "-123.456e-7" 格式直接在字节上算出结果：尾数不超过2^53且10的幂次
+ * 不超过22时，一次乘(除)法即可得到正确舍入的结果；其余情况(nan/inf、超长尾数)
+ * 交给QByteArray::toDouble。
+ */
+bool CsvReader::parseDouble(const char *pcBegin, const char *pcEnd, double *pdValue)
+{
+    static const double s_adPow10[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    while(pcBegin < pcEnd && (*pcBegin == ' ' || *pcBegin == '\t'))
+    {
+        pcBegin++;
+    }
+
+    while(pcEnd > pcBegin && (*(pcEnd - 1) == ' ' || *(pcEnd - 1) == '\t'))
+    {
+        pcEnd--;
+    }
+
+    if(pcBegin == pcEnd)
+    {
+        return false;
+    }
+
+    const char *p = pcBegin;
+
+    bool bNegative = false;
+
+    if(*p == '-' || *p == '+')
+    {
+        bNegative = (*p == '-');
+        p++;
+    }
+
+    quint64 ulMantissa = 0;
+    int iDigits = 0;
+    int iExp10 = 0;
+    bool bAnyDigit = false;
+    bool bFast = true;
+
+    /* 整数部分 */
+    while(p < pcEnd && *p >= '0' && *p <= '9')
+    {
+        bAnyDigit = true;
+
+        if(iDigits < 19)
+        {
+            ulMantissa = ulMantissa*10 + (*p - '0');
+
+            if(ulMantissa != 0)
+            {
+                iDigits++;
+            }
+        }
+        else
+        {
+            iExp10++;
+            bFast = false;
+        }
+        p++;
+    }
+
+    /* 小数部分 */
+    if(p < pcEnd && *p == '.')
+    {
+        p++;
+
+        while(p < pcEnd && *p >= '0' && *p <= '9')
+        {
+            bAnyDigit = true;
+
+            if(iDigits < 19)
+            {
+                ulMantissa = ulMantissa*10 + (*p - '0');
+                iExp10--;
+
+                if(ulMantissa != 0)
+                {
+                    iDigits++;
+                }
+            }
+            else
+            {
+                bFast = false;
+            }
+            p++;
+        }
+    }
+
+    /* 指数部分 */
+    if(bAnyDigit && p < pcEnd && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+
+        bool bExpNegative = false;
+
+        if(p < pcEnd && (*p == '-' || *p == '+'))
+        {
+            bExpNegative = (*p == '-');
+            p++;
+        }
+
+        if(p == pcEnd || *p < '0' || *p > '9')
+        {
+            bFast = false;
+        }
+
+        int iExp = 0;
+
+        while(p < pcEnd && *p >= '0' && *p <= '9')
+        {
+            if(iExp < 10000)
+            {
+                iExp = iExp*10 + (*p - '0');
+            }
+            p++;
+        }
+
+        iExp10 += bExpNegative ? -iExp : iExp;
+    }
+
+    if(bFast && bAnyDigit && p == pcEnd &&
+            ulMantissa <= (Q_UINT64_C(1) << 53) && iExp10 >= -22 && iExp10 <= 22)
+    {
+        double dValue = (double)ulMantissa;
+
+        if(iExp10 < 0)
+        {
+            dValue /= s_adPow10[-iExp10];
+        }
+        else
+        {
+            dValue *= s_adPow10[iExp10];
+        }
+
+        *pdValue = bNegative ? -dValue : dValue;
+
+        return true;
+    }
+
+    /* 少见格式，走Qt的C locale解析 */
+    bool bOk = false;
+
+    *pdValue = QByteArray::fromRawData(pcBegin, pcEnd - pcBegin).toDouble(&bOk);
+
+    return bOk;
+}
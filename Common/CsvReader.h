@@ -0,0 +1,101 @@
+/**********************************************************************
+ * csv文本解析
+ *
+ * 直接在原始字节上逐行切分，兼容CRLF和LF换行，开头的UTF-8 BOM跳过；
+ * 数值用与语言环境无关的快速解析。格式有误的行用error()记下行号和原因。
+ *
+ * 用法：
+ *     CsvReader oReader(pcData, pcData + iSize);
+ *     QVector<CSV_FIELD> aoField;
+ *     while(oReader.readLine())
+ *     {
+ *         oReader.split(&aoField);
+ *         ...
+ *     }
+ */
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <QVector>
+#include <QStringList>
+
+#include "Common/PublicDef.h"
+
+/* 一个字段在缓冲区中的起止位置(不含逗号) */
+typedef struct _CSV_FIELD
+{
+    const char *pcBegin;
+    const char *pcEnd;
+}CSV_FIELD;
+
+class CsvReader
+{
+public:
+    /* iBase为pcBegin在文件中的偏移，iFirstLineNo为第一行的行号(未知时给0，报错改用偏移) */
+    CsvReader(const char *pcBegin, const char *pcEnd, qint64 iBase = 0, qint64 iFirstLineNo = 1);
+
+    /* 取下一行，到末尾返回false。
+     * bWaitEol为true时，没有换行符的最后一行不取(文件可能还在写) */
+    bool readLine(bool bWaitEol = false);
+
+    /* 当前行，不含换行符 */
+    const char *lineBegin() const { return gpcLine; }
+    const char *lineEnd() const { return gpcLineEnd; }
+
+    bool isEmptyLine() const { return gpcLine == gpcLineEnd; }
+
+    /* 当前行是否以换行符结束 */
+    bool lineHasEol() const { return gbLineEol; }
+
+    /* 当前行行首的文件偏移 */
+    qint64 lineOffset() const { return giBase + (gpcLine - gpcBegin); }
+
+    /* 下一次读取的文件偏移 */
+    qint64 pos() const { return giBase + (gpcNext - gpcBegin); }
+
+    /* 当前行的行号，未知时为-1 */
+    qint64 lineNo() const { return giLineNo; }
+
+    /* 按逗号切分当前行，返回字段数。bSkipEmpty为true时跳过空字段(同QString::SkipEmptyParts) */
+    int split(QVector<CSV_FIELD> *paoField, bool bSkipEmpty = true) const;
+
+    /* 记一条当前行的格式错误 */
+    void error(QString oStrMsg);
+
+    QStringList errors() const { return gaoStrErr; }
+
+    int errorCount() const { return giErrCnt; }
+
+    /* 与语言环境无关的浮点数解析，字段两端的空白忽略 */
+    static bool parseDouble(const char *pcBegin, const char *pcEnd, double *pdValue);
+
+    static bool toDouble(const CSV_FIELD &sField, double *pdValue)
+    {
+        return parseDouble(sField.pcBegin, sField.pcEnd, pdValue);
+    }
+
+    static bool toInt(const CSV_FIELD &sField, int *piValue);
+
+    /* 字段转为文本，按本地编码(与QTextStream默认一致)，两端空白去掉 */
+    static QString toString(const CSV_FIELD &sField);
+
+private:
+    const char *gpcBegin;
+    const char *gpcEnd;
+
+    const char *gpcLine;
+    const char *gpcLineEnd;
+    const char *gpcNext;
+
+    bool gbLineEol;
+
+    qint64 giBase;
+
+    qint64 giLineNo;
+
+    QStringList gaoStrErr;
+
+    int giErrCnt;
+};
+
+#endif // CSVREADER_H
@@ -33,6 +33,13 @@
 /* Last Dir log */
 #define LASTDIR    "LastDirLog.ini"
 
+/* Last project(database file) log */
+#define LASTPROJECT    "LastProject.ini"
+
+/* 视电阻率反演参数：[Solver] Tol=容差 MaxIter=正演次数上限 Table=是否查表反演(true/false，默认false)
+ * [Quadrature] Tol=沿AB求积的相对容差(0为NDIV段) */
+#define RHOSOLVER    "RhoSolver.ini"
+
 #define FloatPrecision 3
 
 struct STATION_INFO
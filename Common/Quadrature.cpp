@@ -0,0 +1,189 @@
+#include "Common/Quadrature.h"
+
+#include <QtGlobal>
+
+#include <cmath>
+
+/******************************************************************
+ * 节点为Legendre多项式P_n的零点，以cos(π(i-1/4)/(n+1/2))为初值牛顿迭代；
+ * 权 w = 2/((1-x²)P_n'(x)²)。
+ */
+void Quadrature::gaussLegendre(int iN, QVector<double> &adX, QVector<double> &adW)
+{
+    adX.resize(iN);
+    adW.resize(iN);
+
+    for(int i = 0; i < iN; i++)
+    {
+        double dX = cos(M_PI*(i + 0.75)/(iN + 0.5));
+        double dDp = 1;
+
+        for(int iIter = 0; iIter < 100; iIter++)
+        {
+            double dP0 = 1, dP1 = dX;
+
+            for(int k = 2; k <= iN; k++)
+            {
+                double dP2 = ((2*k - 1)*dX*dP1 - (k - 1)*dP0)/k;
+
+                dP0 = dP1;
+                dP1 = dP2;
+            }
+
+            dDp = iN*(dX*dP1 - dP0)/(dX*dX - 1);
+
+            double dDx = dP1/dDp;
+
+            dX -= dDx;
+
+            if(qAbs(dDx) < 1e-15)
+            {
+                break;
+            }
+        }
+
+        /* 初值从1往-1排，倒过来存成升序 */
+        adX[iN - 1 - i] = dX;
+        adW[iN - 1 - i] = 2/((1 - dX*dX)*dDp*dDp);
+    }
+}
+
+/* 一段上的Gauss-Legendre：各分量的积分和这一段的节点 */
+static void panel(std::function<void(double, std::complex<double>*)> &oKernel, int iComp,
+                  const QVector<double> &adX, const QVector<double> &adW, double dA, double dB,
+                  QVector< std::complex<double> > &acSum, QVector<double> &adT, QVector<double> &adWeight)
+{
+    double dH = (dB - dA)/2;
+    double dM = (dA + dB)/2;
+
+    acSum.fill(0, iComp);
+    adT.resize(adX.count());
+    adWeight.resize(adX.count());
+
+    QVector< std::complex<double> > acValue(iComp);
+
+    for(int i = 0; i < adX.count(); i++)
+    {
+        adT[i] = dM + dH*adX.at(i);
+        adWeight[i] = dH*adW.at(i);
+
+        oKernel(adT.at(i), acValue.data());
+
+        for(int c = 0; c < iComp; c++)
+        {
+            acSum[c] += adWeight.at(i)*acValue.at(c);
+        }
+    }
+}
+
+/******************************************************************
+ * 用栈代替递归，从左往右处理各段，节点按t升序输出。
+ * 段的积分在它被对分之前已经算过(父段的半段)，每段判断只新算两个半段。
+ * 误差尺度取第一次对分后的积分模。
+ */
+QUAD_RULE Quadrature::adaptive(std::function<void(double, std::complex<double>*)> oKernel, int iComp, double dTol)
+{
+    QUAD_RULE sRule;
+    sRule.iEvals = 0;
+
+    QVector<double> adX, adW;
+    gaussLegendre(QUAD_GL_N, adX, adW);
+
+    typedef struct _PANEL
+    {
+        double dA;
+        double dB;
+        QVector< std::complex<double> > acSum;
+    }PANEL;
+
+    QVector<double> adT, adWeight;
+
+    PANEL sWhole;
+    sWhole.dA = 0;
+    sWhole.dB = 1;
+    panel(oKernel, iComp, adX, adW, 0, 1, sWhole.acSum, adT, adWeight);
+    sRule.iEvals += QUAD_GL_N;
+
+    QVector<double> adScale;
+
+    QList<PANEL> aoStack;
+    aoStack.append(sWhole);
+
+    while(!aoStack.isEmpty())
+    {
+        PANEL sPanel = aoStack.takeLast();
+
+        double dM = (sPanel.dA + sPanel.dB)/2;
+
+        PANEL sLeft, sRight;
+        QVector<double> adTLeft, adWLeft, adTRight, adWRight;
+
+        sLeft.dA = sPanel.dA;
+        sLeft.dB = dM;
+        panel(oKernel, iComp, adX, adW, sLeft.dA, sLeft.dB, sLeft.acSum, adTLeft, adWLeft);
+
+        sRight.dA = dM;
+        sRight.dB = sPanel.dB;
+        panel(oKernel, iComp, adX, adW, sRight.dA, sRight.dB, sRight.acSum, adTRight, adWRight);
+
+        sRule.iEvals += 2*QUAD_GL_N;
+
+        if(adScale.isEmpty())
+        {
+            for(int c = 0; c < iComp; c++)
+            {
+                adScale.append(std::abs(sLeft.acSum.at(c) + sRight.acSum.at(c)));
+            }
+        }
+
+        bool bOk = (sPanel.dB - sPanel.dA) <= QUAD_MIN_WIDTH;
+
+        if(!bOk)
+        {
+            bOk = true;
+
+            for(int c = 0; c < iComp; c++)
+            {
+                double dDiff = std::abs(sLeft.acSum.at(c) + sRight.acSum.at(c) - sPanel.acSum.at(c));
+
+                if(dDiff > dTol*adScale.at(c)*(sPanel.dB - sPanel.dA))
+                {
+                    bOk = false;
+                    break;
+                }
+            }
+        }
+
+        if(bOk)
+        {
+            sRule.adT<<adTLeft<<adTRight;
+            sRule.adW<<adWLeft<<adWRight;
+        }
+        else
+        {
+            /* 左半段后入栈，先处理 */
+            aoStack.append(sRight);
+            aoStack.append(sLeft);
+        }
+    }
+
+    return sRule;
+}
+
+QUAD_RULE Quadrature::midpoint(int iN)
+{
+    QUAD_RULE sRule;
+    sRule.iEvals = 0;
+
+    sRule.adT.resize(iN);
+    sRule.adW.resize(iN);
+
+    for(int j = 1; j < iN + 1; j++)
+    {
+        //center_x(ii) = xa + (xb - xa)/2/nn*(2*ii-1);
+        sRule.adT[j-1] = (2.0*j - 1)/(2*iN);
+        sRule.adW[j-1] = 1.0/iN;
+    }
+
+    return sRule;
+}
@@ -0,0 +1,47 @@
+/**********************************************************************
+ * 自适应Gauss-Legendre求积
+ *
+ * 在[0,1]上求 ∫f(t)dt，f可以有多个(复数)分量。每段用QUAD_GL_N点Gauss-Legendre，
+ * 与对分后两个半段的结果比较，差在容差内就保留两个半段的节点，否则两半各自再分。
+ * 得到的是一组节点和权，之后对同一区间上变化相近的被积函数(如不同ρ、不同频率)
+ * 直接加权求和，不必再判断误差。
+ */
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <QVector>
+
+#include <complex>
+#include <functional>
+
+/* 每段的Gauss-Legendre点数 */
+#define QUAD_GL_N       6
+
+/* 最短的段长：测点几乎在积分线上时不再细分 */
+#define QUAD_MIN_WIDTH  (1.0/1024)
+
+typedef struct _QUAD_RULE
+{
+    /* 节点(0~1)和权，权之和为1 */
+    QVector<double> adT;
+    QVector<double> adW;
+
+    /* 建立时调用被积函数的次数 */
+    int iEvals;
+}QUAD_RULE;
+
+class Quadrature
+{
+public:
+    /* iN点Gauss-Legendre在[-1,1]上的节点和权 */
+    static void gaussLegendre(int iN, QVector<double> &adX, QVector<double> &adW);
+
+    /* oKernel(t, pcValue)把t处iComp个分量写进pcValue。
+     * 每段的误差要求：各分量 |Q(两半) - Q(整段)| <= dTol*|∫f|*段长 */
+    static QUAD_RULE adaptive(std::function<void(double, std::complex<double>*)> oKernel, int iComp, double dTol);
+
+    /* iN段中点公式，用于对比 */
+    static QUAD_RULE midpoint(int iN);
+};
+
+#endif // QUADRATURE_H
@@ -0,0 +1,153 @@
+#include "Common/RhoSolver.h"
+
+#include <QtGlobal>
+
+#include <cmath>
+#include <algorithm>
+
+SOLVER_OPT RhoSolver::defaultOpt()
+{
+    SOLVER_OPT sOpt;
+
+    sOpt.dTol = RHO_TOL;
+    sOpt.iMaxIter = RHO_MAX_ITER;
+
+    return sOpt;
+}
+
+/******************************************************************
+ * x0 = ln(dRho0)，第一步按斜率1(近区)走：x1 = x0 - h0，
+ * 之后用最近两点的割线斜率；斜率不为正(非单调或数值问题)时仍按1走。
+ * |Δx| < dTol(ρ的相对变化，与原迭代的判据相同) 或 |h| < dTol/2 即收敛，
+ * 斜率不小于0.5，|h| < dTol/2 时ρ的相对误差不超过dTol。
+ */
+SOLVER_RESULT RhoSolver::solve(std::function<double(double)> oForward, double dE, double dRho0, const SOLVER_OPT &sOpt)
+{
+    SOLVER_RESULT sResult;
+
+    sResult.dRho = dRho0;
+    sResult.iIter = 0;
+    sResult.dResidual = 0;
+    sResult.bConverged = false;
+
+    if(!(dE > 0) || !(dRho0 > 0))
+    {
+        return sResult;
+    }
+
+    const double dLogE = log(dE);
+
+    /* 括住根的区间：h(dLo) < 0 < h(dHi) */
+    bool bLo = false, bHi = false;
+    double dLo = 0, dHi = 0;
+
+    double dX0 = log(dRho0);
+    double dH0 = log(oForward(dRho0)) - dLogE;
+
+    sResult.iIter = 1;
+
+    double dX1 = dX0;
+    double dH1 = dH0;
+
+    double dStep = -std::max(-RHO_MAX_STEP, std::min(RHO_MAX_STEP, dH0));
+
+    while(std::isfinite(dH1))
+    {
+        if(dH1 < 0)
+        {
+            dLo = bLo ? std::max(dLo, dX1) : dX1;
+            bLo = true;
+        }
+        else
+        {
+            dHi = bHi ? std::min(dHi, dX1) : dX1;
+            bHi = true;
+        }
+
+        if(qAbs(dH1) < sOpt.dTol/2 || (sResult.iIter > 1 && qAbs(dX1 - dX0) < sOpt.dTol))
+        {
+            sResult.bConverged = true;
+            break;
+        }
+
+        if(sResult.iIter >= sOpt.iMaxIter)
+        {
+            break;
+        }
+
+        if(sResult.iIter > 1)
+        {
+            double dSlope = (dH1 - dH0)/(dX1 - dX0);
+
+            if(!(dSlope > 0) || !std::isfinite(dSlope))
+            {
+                dSlope = 1;
+            }
+
+            dStep = std::max(-RHO_MAX_STEP, std::min(RHO_MAX_STEP, -dH1/dSlope));
+        }
+
+        double dX = dX1 + dStep;
+
+        if(bLo && bHi && !(dX > dLo && dX < dHi))
+        {
+            dX = (dLo + dHi)/2;
+        }
+
+        dX0 = dX1;
+        dH0 = dH1;
+
+        dX1 = dX;
+        dH1 = log(oForward(exp(dX1))) - dLogE;
+
+        sResult.iIter++;
+    }
+
+    sResult.dRho = exp(dX1);
+    sResult.dResidual = std::isfinite(dH1) ? qAbs(exp(dH1) - 1) : HUGE_VAL;
+
+    return sResult;
+}
+
+/* ρ ← ρ·|E实测|/|E(ρ)|，即原来的 dRho = abs(dE/cca) */
+SOLVER_RESULT RhoSolver::fixedPoint(std::function<double(double)> oForward, double dE, double dRho0, const SOLVER_OPT &sOpt)
+{
+    SOLVER_RESULT sResult;
+
+    sResult.dRho = dRho0;
+    sResult.iIter = 0;
+    sResult.dResidual = HUGE_VAL;
+    sResult.bConverged = false;
+
+    double dRho = dRho0;
+
+    while(sResult.iIter < sOpt.iMaxIter)
+    {
+        double dField = oForward(dRho);
+
+        sResult.iIter++;
+
+        sResult.dResidual = qAbs(dField/dE - 1);
+
+        double dNext = dRho*dE/dField;
+
+        if(!std::isfinite(dNext))
+        {
+            break;
+        }
+
+        bool bDone = qAbs((dNext - dRho)/dRho) < sOpt.dTol;
+
+        dRho = dNext;
+
+        if(bDone)
+        {
+            sResult.bConverged = true;
+            break;
+        }
+    }
+
+    sResult.dRho = dRho;
+
+    return sResult;
+}
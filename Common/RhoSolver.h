@@ -0,0 +1,53 @@
+/**********************************************************************
+ * 视电阻率反演：求ρ使正演场强 |E(ρ)| 等于实测场强
+ *
+ * 在 x = lnρ、h(x) = ln|E(ρ)| - ln|E实测| 上做带保护的割线法：
+ * |E|随ρ单调增，h一旦变号就记下括住根的区间，割线步落到区间外时改用二分；
+ * 还没括住时每步最多走RHO_MAX_STEP(两个数量级)。
+ * 近区|E|∝ρ、远区|E|∝√ρ，h对x的斜率在0.5~1之间，割线法一般3~5次正演收敛，
+ * 原不动点迭代 ρ ← ρ·|E实测|/|E(ρ)| 远区只线性收敛，个别几何下来回振荡。
+ */
+#ifndef RHOSOLVER_H
+#define RHOSOLVER_H
+
+#include <functional>
+
+/* 默认的收敛容差(ρ的相对变化)和正演次数上限，可在RHOSOLVER文件中修改 */
+#define RHO_TOL         0.0005
+#define RHO_MAX_ITER    50
+
+/* 还没括住根时每步lnρ的最大变化：ln(100) */
+#define RHO_MAX_STEP    4.6
+
+typedef struct _SOLVER_OPT
+{
+    double dTol;
+    int iMaxIter;
+}SOLVER_OPT;
+
+typedef struct _SOLVER_RESULT
+{
+    double dRho;
+
+    /* 正演次数 */
+    int iIter;
+
+    /* 结束时 |E(ρ)/E实测 - 1| */
+    double dResidual;
+
+    bool bConverged;
+}SOLVER_RESULT;
+
+class RhoSolver
+{
+public:
+    static SOLVER_OPT defaultOpt();
+
+    /* oForward(ρ)返回正演场强的模，dE为实测场强(>0)，dRho0为初值 */
+    static SOLVER_RESULT solve(std::function<double(double)> oForward, double dE, double dRho0, const SOLVER_OPT &sOpt);
+
+    /* 原不动点迭代，加了次数上限，用于对比 */
+    static SOLVER_RESULT fixedPoint(std::function<double(double)> oForward, double dE, double dRho0, const SOLVER_OPT &sOpt);
+};
+
+#endif // RHOSOLVER_H
@@ -0,0 +1,179 @@
+#include "Common/RhoTable.h"
+
+#include <QtGlobal>
+
+#include <cmath>
+
+QVector<double> RhoTable::grid()
+{
+    const double dStep = log(10.0)/RHO_TABLE_PER_DECADE;
+
+    const int iCnt = qRound(log10(RHO_TABLE_MAX/RHO_TABLE_MIN)*RHO_TABLE_PER_DECADE) + 1;
+
+    QVector<double> adLogRho(iCnt);
+
+    for(int i = 0; i < iCnt; i++)
+    {
+        adLogRho[i] = log(RHO_TABLE_MIN) + i*dStep;
+    }
+
+    return adLogRho;
+}
+
+RHO_TABLE RhoTable::build(std::function<void(const double*, int, double*)> oBatch)
+{
+    RHO_TABLE sTable;
+
+    sTable.adLogRho = grid();
+
+    const int iCnt = sTable.adLogRho.count();
+
+    QVector<double> adRho(iCnt);
+
+    for(int i = 0; i < iCnt; i++)
+    {
+        adRho[i] = exp(sTable.adLogRho.at(i));
+    }
+
+    sTable.adLogE.resize(iCnt);
+
+    oBatch(adRho.constData(), iCnt, sTable.adLogE.data());
+
+    sTable.bMonotone = true;
+
+    for(int i = 0; i < iCnt; i++)
+    {
+        sTable.adLogE[i] = log(sTable.adLogE.at(i));
+
+        if(!std::isfinite(sTable.adLogE.at(i)) || (i > 0 && !(sTable.adLogE.at(i) > sTable.adLogE.at(i - 1))))
+        {
+            sTable.bMonotone = false;
+        }
+    }
+
+    return sTable;
+}
+
+/******************************************************************
+ * 以y = ln|E/I|为自变量对x = lnρ做单调三次Hermite插值：
+ * 节点斜率取相邻两段割线斜率的加权调和平均(Fritsch-Carlson)，端点取单侧割线斜率，
+ * 割线斜率都为正，插值也单调。
+ */
+SOLVER_RESULT RhoTable::invert(const RHO_TABLE &sTable, std::function<double(double)> oForward,
+                               double dE, double dRho0, const SOLVER_OPT &sOpt)
+{
+    const QVector<double> &adX = sTable.adLogRho;
+    const QVector<double> &adY = sTable.adLogE;
+
+    const int iCnt = adY.count();
+
+    if(!sTable.bMonotone || iCnt < 2 || !(dE > 0))
+    {
+        return RhoSolver::solve(oForward, dE, dRho0, sOpt);
+    }
+
+    const double dY = log(dE);
+
+    if(!(dY >= adY.first() && dY <= adY.last()))
+    {
+        return RhoSolver::solve(oForward, dE, dRho0, sOpt);
+    }
+
+    /* adY[m] <= dY <= adY[m+1] */
+    int iLo = 0, iHi = iCnt - 1;
+
+    while(iHi - iLo > 1)
+    {
+        int iMid = (iLo + iHi)/2;
+
+        if(adY.at(iMid) <= dY)
+        {
+            iLo = iMid;
+        }
+        else
+        {
+            iHi = iMid;
+        }
+    }
+
+    const int m = iLo;
+
+    /* 第i段的割线斜率dx/dy和段长 */
+    auto secant = [&](int i) -> double
+    {
+        return (adX.at(i + 1) - adX.at(i))/(adY.at(i + 1) - adY.at(i));
+    };
+
+    auto width = [&](int i) -> double
+    {
+        return adY.at(i + 1) - adY.at(i);
+    };
+
+    auto slope = [&](int i) -> double
+    {
+        if(i == 0)
+        {
+            return secant(0);
+        }
+
+        if(i == iCnt - 1)
+        {
+            return secant(iCnt - 2);
+        }
+
+        double dW1 = 2*width(i) + width(i - 1);
+        double dW2 = width(i) + 2*width(i - 1);
+
+        return (dW1 + dW2)/(dW1/secant(i - 1) + dW2/secant(i));
+    };
+
+    double dH = width(m);
+    double dT = (dY - adY.at(m))/dH;
+
+    double dT2 = dT*dT;
+    double dT3 = dT2*dT;
+
+    double dX = (2*dT3 - 3*dT2 + 1)*adX.at(m) + (dT3 - 2*dT2 + dT)*dH*slope(m)
+            + (-2*dT3 + 3*dT2)*adX.at(m + 1) + (dT3 - dT2)*dH*slope(m + 1);
+
+    /* 修正一步：正演一次，按这一段的割线斜率 */
+    double dResidual = log(oForward(exp(dX))) - dY;
+
+    if(!std::isfinite(dResidual))
+    {
+        return RhoSolver::solve(oForward, dE, dRho0, sOpt);
+    }
+
+    double dStep = -dResidual*secant(m);
+
+    if(qAbs(dStep) >= sOpt.dTol)
+    {
+        SOLVER_RESULT sResult = RhoSolver::solve(oForward, dE, exp(dX + dStep), sOpt);
+
+        sResult.iIter += 1;
+
+        return sResult;
+    }
+
+    /* 再正演一次，残差按修正后返回的ρ计算 */
+    double dRho = exp(dX + dStep);
+    double dResidualPolish = log(oForward(dRho)) - dY;
+
+    if(!std::isfinite(dResidualPolish))
+    {
+        SOLVER_RESULT sResult = RhoSolver::solve(oForward, dE, dRho, sOpt);
+
+        sResult.iIter += 2;
+
+        return sResult;
+    }
+
+    SOLVER_RESULT sResult;
+
+    sResult.dRho = dRho;
+    sResult.iIter = 2;
+    sResult.dResidual = qAbs(exp(dResidualPolish) - 1);
+    sResult.bConverged = true;
+
+    return sResult;
+}
@@ -0,0 +1,52 @@
+/**********************************************************************
+ * 查表反演视电阻率
+ *
+ * 站点几何和频率定了以后，ρ → |E/I| 是光滑的单调函数。
+ * 在RHO_TABLE_MIN~RHO_TABLE_MAX上按对数等距取ρ，一次算出整张正演表(ln|E/I| 对 lnρ)，
+ * 实测场值用单调三次Hermite插值(Fritsch-Carlson)反查出lnρ，再正演一次按割线修正一步。
+ * 表只与几何和频率有关，与场值无关，修改场值后重算整条测线时可以直接复用。
+ * 表不单调(如Ex靠近场值为零的方位)或场值超出表的范围时改用RhoSolver迭代。
+ */
+#ifndef RHOTABLE_H
+#define RHOTABLE_H
+
+#include <QVector>
+
+#include <functional>
+
+#include "Common/RhoSolver.h"
+
+/* 表的ρ范围(Ω·m)和每十倍的点数 */
+#define RHO_TABLE_MIN           0.1
+#define RHO_TABLE_MAX           1e6
+#define RHO_TABLE_PER_DECADE    10
+
+typedef struct _RHO_TABLE
+{
+    /* lnρ，对数等距 */
+    QVector<double> adLogRho;
+
+    /* ln|E/I| */
+    QVector<double> adLogE;
+
+    /* adLogE严格递增 */
+    bool bMonotone;
+}RHO_TABLE;
+
+class RhoTable
+{
+public:
+    /* 表的lnρ节点 */
+    static QVector<double> grid();
+
+    /* oBatch(pdRho, iCnt, pdE)一次算出iCnt个ρ的|E/I| */
+    static RHO_TABLE build(std::function<void(const double*, int, double*)> oBatch);
+
+    /* 查表得到ρ，oForward(ρ)返回|E/I|，dE为实测|E/I|。
+     * 修正一步的变化小于容差即收敛，再正演一次得到修正后ρ处的dResidual(共2次正演)；
+     * 否则以修正后的ρ为初值用RhoSolver继续 */
+    static SOLVER_RESULT invert(const RHO_TABLE &sTable, std::function<double(double)> oForward,
+                                double dE, double dRho0, const SOLVER_OPT &sOpt);
+};
+
+#endif // RHOTABLE_H
@@ -0,0 +1,241 @@
+#include "Common/Stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+double Stats::mean(const double *pdData, qint64 iCnt)
+{
+    if(iCnt <= 0)
+    {
+        return 0;
+    }
+
+    double dSum0 = 0, dSum1 = 0, dSum2 = 0, dSum3 = 0;
+
+    qint64 i = 0;
+
+    for(; i + 4 <= iCnt; i += 4)
+    {
+        dSum0 += pdData[i];
+        dSum1 += pdData[i + 1];
+        dSum2 += pdData[i + 2];
+        dSum3 += pdData[i + 3];
+    }
+
+    for(; i < iCnt; i++)
+    {
+        dSum0 += pdData[i];
+    }
+
+    return ((dSum0 + dSum1) + (dSum2 + dSum3))/iCnt;
+}
+
+double Stats::relErr(const double *pdData, qint64 iCnt)
+{
+    double dMean = 0, dRelErr = 0;
+
+    meanRelErr(pdData, iCnt, &dMean, &dRelErr);
+
+    return dRelErr;
+}
+
+/******************************************************************
+ * 以 K = pdData[0] 为偏移，d = x - K：
+ * avg = K + Σd/n
+ * Σ(x-avg)² = Σd² - (Σd)²/n
+ * 散点都在平均值附近，偏移后Σd²不会因大数相消损失精度。
+ */
+void Stats::meanRelErr(const double *pdData, qint64 iCnt, double *pdMean, double *pdRelErr)
+{
+    *pdMean = 0;
+    *pdRelErr = 0;
+
+    if(iCnt <= 0)
+    {
+        return;
+    }
+
+    const double dK = pdData[0];
+
+    double dS0 = 0, dS1 = 0, dS2 = 0, dS3 = 0;
+    double dQ0 = 0, dQ1 = 0, dQ2 = 0, dQ3 = 0;
+
+    qint64 i = 0;
+
+    for(; i + 4 <= iCnt; i += 4)
+    {
+        double d0 = pdData[i]     - dK;
+        double d1 = pdData[i + 1] - dK;
+        double d2 = pdData[i + 2] - dK;
+        double d3 = pdData[i + 3] - dK;
+
+        dS0 += d0; dQ0 += d0*d0;
+        dS1 += d1; dQ1 += d1*d1;
+        dS2 += d2; dQ2 += d2*d2;
+        dS3 += d3; dQ3 += d3*d3;
+    }
+
+    for(; i < iCnt; i++)
+    {
+        double d = pdData[i] - dK;
+
+        dS0 += d; dQ0 += d*d;
+    }
+
+    double dSum = (dS0 + dS1) + (dS2 + dS3);
+    double dSq  = (dQ0 + dQ1) + (dQ2 + dQ3);
+
+    double dMean = dK + dSum/iCnt;
+
+    double dVar = (dSq - dSum*dSum/iCnt)/iCnt;
+
+    if(dVar < 0)
+    {
+        dVar = 0;
+    }
+
+    *pdMean = dMean;
+
+    /* 与原算法一致：平均值为0时结果为inf/nan */
+    *pdRelErr = std::sqrt(dVar)/std::fabs(dMean) * 100;
+}
+
+double Stats::min(const double *pdData, qint64 iCnt)
+{
+    if(iCnt <= 0)
+    {
+        return 0;
+    }
+
+    double dMin0 = pdData[0], dMin1 = pdData[0], dMin2 = pdData[0], dMin3 = pdData[0];
+
+    qint64 i = 0;
+
+    for(; i + 4 <= iCnt; i += 4)
+    {
+        dMin0 = pdData[i]     < dMin0 ? pdData[i]     : dMin0;
+        dMin1 = pdData[i + 1] < dMin1 ? pdData[i + 1] : dMin1;
+        dMin2 = pdData[i + 2] < dMin2 ? pdData[i + 2] : dMin2;
+        dMin3 = pdData[i + 3] < dMin3 ? pdData[i + 3] : dMin3;
+    }
+
+    for(; i < iCnt; i++)
+    {
+        dMin0 = pdData[i] < dMin0 ? pdData[i] : dMin0;
+    }
+
+    return qMin(qMin(dMin0, dMin1), qMin(dMin2, dMin3));
+}
+
+double Stats::max(const double *pdData, qint64 iCnt)
+{
+    if(iCnt <= 0)
+    {
+        return 0;
+    }
+
+    double dMax0 = pdData[0], dMax1 = pdData[0], dMax2 = pdData[0], dMax3 = pdData[0];
+
+    qint64 i = 0;
+
+    for(; i + 4 <= iCnt; i += 4)
+    {
+        dMax0 = pdData[i]     > dMax0 ? pdData[i]     : dMax0;
+        dMax1 = pdData[i + 1] > dMax1 ? pdData[i + 1] : dMax1;
+        dMax2 = pdData[i + 2] > dMax2 ? pdData[i + 2] : dMax2;
+        dMax3 = pdData[i + 3] > dMax3 ? pdData[i + 3] : dMax3;
+    }
+
+    for(; i < iCnt; i++)
+    {
+        dMax0 = pdData[i] > dMax0 ? pdData[i] : dMax0;
+    }
+
+    return qMax(qMax(dMax0, dMax1), qMax(dMax2, dMax3));
+}
+
+/* adTmp会被打乱顺序；偶数个时取中间两个的平均 */
+static double medianInPlace(QVector<double> &adTmp)
+{
+    qint64 iCnt = adTmp.count();
+
+    double *pdBegin = adTmp.data();
+
+    double *pdMid = pdBegin + iCnt/2;
+
+    std::nth_element(pdBegin, pdMid, pdBegin + iCnt);
+
+    double dMedian = *pdMid;
+
+    if(iCnt%2 == 0)
+    {
+        dMedian = (dMedian + *std::max_element(pdBegin, pdMid))/2;
+    }
+
+    return dMedian;
+}
+
+double Stats::median(const double *pdData, qint64 iCnt)
+{
+    if(iCnt <= 0)
+    {
+        return 0;
+    }
+
+    QVector<double> adTmp(iCnt);
+
+    std::copy(pdData, pdData + iCnt, adTmp.begin());
+
+    return medianInPlace(adTmp);
+}
+
+double Stats::mad(const double *pdData, qint64 iCnt)
+{
+    if(iCnt <= 0)
+    {
+        return 0;
+    }
+
+    QVector<double> adTmp(iCnt);
+
+    std::copy(pdData, pdData + iCnt, adTmp.begin());
+
+    double dMedian = medianInPlace(adTmp);
+
+    for(qint64 i = 0; i < iCnt; i++)
+    {
+        adTmp[i] = std::fabs(pdData[i] - dMedian);
+    }
+
+    return medianInPlace(adTmp);
+}
+
+double Stats::trimmedMean(const double *pdData, qint64 iCnt, double dTrim)
+{
+    if(iCnt <= 0)
+    {
+        return 0;
+    }
+
+    dTrim = qBound(0.0, dTrim, 0.5);
+
+    qint64 iCut = (qint64)(iCnt*dTrim);
+
+    if(2*iCut >= iCnt)
+    {
+        return median(pdData, iCnt);
+    }
+
+    QVector<double> adTmp(iCnt);
+
+    std::copy(pdData, pdData + iCnt, adTmp.begin());
+
+    double *pdBegin = adTmp.data();
+    double *pdEnd   = pdBegin + iCnt;
+
+    /* 只需把两端各iCut个值分出去，中间部分不必有序 */
+    std::nth_element(pdBegin, pdBegin + iCut, pdEnd);
+    std::nth_element(pdBegin + iCut, pdEnd - iCut - 1, pdEnd);
+
+    return mean(pdBegin + iCut, iCnt - 2*iCut);
+}
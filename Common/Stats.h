@@ -0,0 +1,47 @@
+/**********************************************************************
+ * 统计计算
+ *
+ * 均作用在连续内存 pdData[0] ~ pdData[iCnt-1] 上，不拷贝输入；
+ * 求和用4路独立累加，便于编译器向量化。iCnt为0时返回0。
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <QVector>
+
+class Stats
+{
+public:
+    static double mean(const double *pdData, qint64 iCnt);
+
+    /* 相对均方误差(%)：sqrt(Σ((x-avg)/avg)²/n)*100，单次遍历(以首个值为偏移量，避免大数相消) */
+    static double relErr(const double *pdData, qint64 iCnt);
+
+    /* 一次遍历同时得到平均值和相对均方误差 */
+    static void meanRelErr(const double *pdData, qint64 iCnt, double *pdMean, double *pdRelErr);
+
+    static double min(const double *pdData, qint64 iCnt);
+
+    static double max(const double *pdData, qint64 iCnt);
+
+    /* 以下需要排序，内部使用一份临时拷贝 */
+    static double median(const double *pdData, qint64 iCnt);
+
+    /* 绝对中位差：median(|x - median(x)|) */
+    static double mad(const double *pdData, qint64 iCnt);
+
+    /* 截尾平均：两端各去掉 dTrim(0~0.5) 比例的数据后求平均 */
+    static double trimmedMean(const double *pdData, qint64 iCnt, double dTrim);
+
+    static double mean(const QVector<double> &adData)
+    {
+        return mean(adData.constData(), adData.count());
+    }
+
+    static double relErr(const QVector<double> &adData)
+    {
+        return relErr(adData.constData(), adData.count());
+    }
+};
+
+#endif // STATS_H
@@ -2,7 +2,8 @@
 
 CustomTableModel::CustomTableModel(QObject *parent, QSqlDatabase db) : QSqlTableModel(parent,db)
 {
-
+    giBoldFirst = 5;
+    giBoldLast  = 9;
 }
 
 CustomTableModel::~CustomTableModel()
@@ -20,9 +21,16 @@ QVariant CustomTableModel::data(const QModelIndex &idx, int role) const
         return value;
     }
 
+    if(Qt::DisplayRole == role && gmapFormat.contains(idx.column()) && !value.isNull())
+    {
+        QPair<int, QString> oFormat = gmapFormat.value(idx.column());
+
+        return QString::number(value.toDouble(), 'f', oFormat.first) + oFormat.second;
+    }
+
     if(Qt::FontRole == role)
     {
-        if(idx.column() >= 5 && idx.column() <= 9)
+        if(giBoldFirst >= 0 && idx.column() >= giBoldFirst && idx.column() <= giBoldLast)
         {
             QFont font;
             font.setBold(true);
@@ -31,3 +39,14 @@ QVariant CustomTableModel::data(const QModelIndex &idx, int role) const
     }
     return value;
 }
+
+void CustomTableModel::setColumnFormat(int iColumn, int iDecimals, QString oStrSuffix)
+{
+    gmapFormat.insert(iColumn, qMakePair(iDecimals, oStrSuffix));
+}
+
+void CustomTableModel::setBoldColumns(int iFirst, int iLast)
+{
+    giBoldFirst = iFirst;
+    giBoldLast  = iLast;
+}
@@ -5,6 +5,7 @@
 
 #include <QColor>
 #include <QFont>
+#include <QMap>
 
 class CustomTableModel : public QSqlTableModel
 {
@@ -16,6 +17,17 @@ public:
 
     QVariant data(const QModelIndex &idx, int role) const;
 
+    /* 数值列的显示格式：小数位数和后缀(如误差的%)，只影响显示，不改存储 */
+    void setColumnFormat(int iColumn, int iDecimals, QString oStrSuffix = QString());
+
+    /* 粗体显示的列范围，默认5~9(视电阻率表的频率到视电阻率)，iFirst < 0时不加粗 */
+    void setBoldColumns(int iFirst, int iLast);
+
+private:
+    QMap<int, QPair<int, QString> > gmapFormat;
+
+    int giBoldFirst, giBoldLast;
+
 signals:
 
 public slots:
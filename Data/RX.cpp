@@ -1,15 +1,110 @@
 #include "Data/RX.h"
 
+#include "Common/Stats.h"
+#include "Common/CsvReader.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include <QSaveFile>
+#include <QDateTime>
+
+/* 二进制缓存文件：与csv同目录，文件名为 csv文件名 + RX_CACHE_SUFFIX */
+#define RX_CACHE_SUFFIX     ".rxc"
+#define RX_CACHE_MAGIC      0x31435852      /* "RXC1" */
+#define RX_CACHE_VERSION    3
+
+/**********************************************************************
+ * 缓存文件布局(本机字节序，各段8字节对齐)：
+ * RX_CACHE_HEAD
+ * LineId\0SiteId\0CompTag\0 (补齐到8字节，共uiStrBytes字节)
+ * double F[n](升序), Avg[n], Err[n]
+ * qint64 RowPos[n], RowLen[n], ScatterCnt[n]
+ * double Scatter[ulSampleCnt](按频点顺序首尾相接)
+ */
+struct RX_CACHE_HEAD
+{
+    quint32 uiMagic;
+    quint32 uiVersion;
+
+    /* 对应csv文件的大小、修改时间(ms)、内容hash，三者都一致才认为缓存有效 */
+    qint64  iCsvSize;
+    qint64  iCsvMTime;
+    quint64 ulCsvHash;
+
+    /* 追加读取的起始位置 */
+    qint64  iParsedEnd;
+
+    qint32  iDevId;
+    qint32  iDevCh;
+
+    quint32 uiFCnt;
+    quint32 uiStrBytes;
+
+    quint64 ulSampleCnt;
+};
+
+bool RX::gbUseCache = true;
+
+QAtomicInt RX::goSerialNext(1);
+
+/* cost单位为KB，默认64MB */
+QCache<QPair<int, double>, QVector<double> > RX::goScatterLru(64*1024);
+
+QMutex RX::goScatterLruMutex;
 
 RX::RX(QString oStrFileName, QObject *parent):
     oStrCSV(oStrFileName),
     QObject(parent)
 {
+    giParsedEnd = 0;
+
+    giScatterHole = 0;
+
+    gbHoldScatter = false;
+
+    gulCacheHash = 0;
+
+    gulCsvHash = 0;
+
+    giSerial = goSerialNext.fetchAndAddRelaxed(1);
+
     this->importRX(oStrFileName);
 }
 
-/* Import csv file */
-void RX::importRX(QString oStrFileName)
+/* 释放时清掉本对象在LRU缓存中的散点，把额度让给其它RX */
+RX::~RX()
+{
+    QMutexLocker oLocker(&goScatterLruMutex);
+
+    foreach(const QPair<int, double> &oKey, goScatterLru.keys())
+    {
+        if(oKey.first == giSerial)
+        {
+            goScatterLru.remove(oKey);
+        }
+    }
+}
+
+void RX::setScatterBudget(int iMB)
+{
+    QMutexLocker oLocker(&goScatterLruMutex);
+
+    goScatterLru.setMaxCost(qMax(iMB, 0)*1024);
+}
+
+qint64 RX::scatterCacheBytes()
+{
+    QMutexLocker oLocker(&goScatterLruMutex);
+
+    return (qint64)goScatterLru.totalCost()*1024;
+}
+
+/************************************************************************
+ * 解析电场文件名：..._T(x)_L<线号>_S<点号>_D<仪器号>_CH<通道号>_<分量>.csv
+ */
+bool RX::parseFileName(QString oStrFileName, QString *poStrLineId, QString *poStrSiteId,
+                       int *piDevId, int *piDevCh, QString *poStrCompTag)
 {
     QFileInfo oFileInfo(oStrFileName);
 
@@ -23,191 +118,704 @@ void RX::importRX(QString oStrFileName)
 
     //qDebugV0()<<oStrTemp;
 
-    /* 读取文件名里面的信息，摘取线号点号仪器号通道号 */
     QStringList aoStrStationInfo = oStrTemp.split('_', QString::SkipEmptyParts );
 
     //qDebugV0()<<aoStrStationInfo;
 
+    if(iPos == -1 || aoStrStationInfo.count() < 5)
+    {
+        return false;
+    }
+
     /* LineId */
     QString oStrLineId= aoStrStationInfo.at(0);
-    goStrLineId = oStrLineId.remove(0,1);
+    *poStrLineId = oStrLineId.remove(0,1);
 
     /* SiteId */
     QString oStrSiteId= aoStrStationInfo.at(1);
-    goStrSiteId = oStrSiteId.remove(0,1);
+    *poStrSiteId = oStrSiteId.remove(0,1);
 
     /* DevId */
     QString oStrDevId = aoStrStationInfo.at(2);
     oStrDevId.remove(0,1);
-    giDevId = oStrDevId.toInt();
+    *piDevId = oStrDevId.toInt();
 
     /* DevCh */
     QString oStrDevCh= aoStrStationInfo.at(3);
     oStrDevCh.remove(0,2);
-    giDevCh = oStrDevCh.toInt();
+    *piDevCh = oStrDevCh.toInt();
 
     /* Component identifier */
-    QString oStrCompTag= aoStrStationInfo.at(4);
-    goStrCompTag = oStrCompTag;
+    *poStrCompTag = aoStrStationInfo.at(4);
+
+    return true;
+}
+
+/* 整个文件的内容哈希(与缓存校验用的相同)，打不开时返回0 */
+quint64 RX::hashFile(QString oStrFileName)
+{
+    QFile oFile(oStrFileName);
+
+    if(!oFile.open(QIODevice::ReadOnly))
+    {
+        return 0;
+    }
+
+    qint64 iSize = oFile.size();
 
-    /* 读文件内容，场值 */
+    quint64 ulHash = 0;
+
+    uchar *pucData = (iSize > 0) ? oFile.map(0, iSize) : NULL;
+
+    if(pucData != NULL)
+    {
+        ulHash = hashBytes((const char *)pucData, iSize);
+
+        oFile.unmap(pucData);
+    }
+    else
+    {
+        QByteArray aoData = oFile.readAll();
+
+        ulHash = hashBytes(aoData.constData(), aoData.size());
+    }
+
+    oFile.close();
+
+    return ulHash;
+}
+
+/* Import csv file, 失败时返回false，原因记录在oStrErr中 */
+bool RX::importRX(QString oStrFileName)
+{
+    oStrErr.clear();
+
+    /* 读取文件名里面的信息，摘取线号点号仪器号通道号 */
+    if(!parseFileName(oStrFileName, &goStrLineId, &goStrSiteId, &giDevId, &giDevCh, &goStrCompTag))
+    {
+        oStrErr = "文件名格式有误，无法识别线号/点号/仪器号/通道号/分量";
+        return false;
+    }
+
+    /* 读文件内容，场值。整个文件映射到内存，在字节上直接解析，避免逐行QString分配 */
     QFile oFile(oStrFileName);
-    QString oStrLineCSV;
-    oStrLineCSV.clear();
 
-    if(oFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    if(!oFile.open(QIODevice::ReadOnly))
     {
-        QTextStream oStream(&oFile);
+        qDebugV5()<<oStrFileName<<oFile.errorString();
 
-        oStream.seek(0);
+        oStrErr = QString("打开失败：%1").arg(oFile.errorString());
+        return false;
+    }
 
-        QStringList aoStrLineCSV;
+    qint64 iSize = oFile.size();
 
-        QString oStrLineCSV;
+    qint64 iMTime = QFileInfo(oFile).lastModified().toMSecsSinceEpoch();
 
-        while(!oStream.atEnd())
+    if(iSize > 0)
+    {
+        uchar *pucData = oFile.map(0, iSize);
+
+        QByteArray aoData;
+
+        const char *pcData = (const char *)pucData;
+
+        if(pucData == NULL)
         {
-            oStrLineCSV.clear();
+            /* 映射失败(如网络盘)，退回到整块读入 */
+            aoData = oFile.readAll();
+
+            pcData = aoData.constData();
+            iSize  = aoData.size();
+        }
 
-            /*  */
-            oStrLineCSV = oStream.readLine();
+        gulCsvHash = hashBytes(pcData, iSize);
 
-            if(!oStrLineCSV.isEmpty())
+        /* 缓存有效就直接用缓存，否则解析文本并写缓存。
+         * 写缓存需要全部散点，解析期间暂存，写完即丢掉，以后按需读取 */
+        if( !(gbUseCache && this->loadCache(iSize, iMTime)) )
+        {
+            gbHoldScatter = gbUseCache;
+
+            giParsedEnd = this->parseRX(pcData, pcData + iSize);
+
+            if(gbUseCache && !adF.isEmpty())
             {
-                aoStrLineCSV.clear();
+                this->saveCache(iSize, iMTime);
+            }
 
-                aoStrLineCSV = oStrLineCSV.split(',', QString::SkipEmptyParts);
+            gbHoldScatter = false;
 
-                double dF = aoStrLineCSV.first().toDouble();
+            this->releaseScatter();
+        }
 
-                /* 读取到了频率之后，在QStringList中删除掉 */
-                aoStrLineCSV.removeFirst();
+        if(pucData != NULL)
+        {
+            oFile.unmap(pucData);
+        }
+    }
 
-                QVector<double> adScatter;
-                adScatter.clear();
+    oFile.close();
 
-                foreach(QString oStrData, aoStrLineCSV)
-                {
-                    adScatter.append(oStrData.toDouble());
-                }
+    if(adF.isEmpty())
+    {
+        oStrErr = "文件中没有有效数据";
+        return false;
+    }
 
-                adF.append(dF);
+    return true;
+}
 
-                mapScatterList.insert(dF, adScatter);
+/************************************************************************
+ * 读取二进制缓存
+ * csv的大小、修改时间和内容hash(gulCsvHash)都与缓存记录一致才用；
+ * 任何一项不一致或缓存文件损坏，返回false，由调用者解析文本。
+ */
+bool RX::loadCache(qint64 iCsvSize, qint64 iCsvMTime)
+{
+    QFile oFile(oStrCSV + RX_CACHE_SUFFIX);
+
+    if(!oFile.exists() || !oFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
 
-                mapAvg.insert(dF, getAvg(adScatter));
+    qint64 iSize = oFile.size();
 
-                mapErr.insert(dF, getErr(adScatter));
-            }
-            else
+    if(iSize < (qint64)sizeof(RX_CACHE_HEAD))
+    {
+        return false;
+    }
+
+    uchar *pucData = oFile.map(0, iSize);
+
+    if(pucData == NULL)
+    {
+        return false;
+    }
+
+    const char *pcData = (const char *)pucData;
+
+    RX_CACHE_HEAD sHead;
+    memcpy(&sHead, pcData, sizeof(sHead));
+
+    quint64 ulFCnt = sHead.uiFCnt;
+
+    quint64 ulExpect = sizeof(RX_CACHE_HEAD) + sHead.uiStrBytes +
+            ulFCnt*6*sizeof(double) + sHead.ulSampleCnt*sizeof(double);
+
+    bool bValid = ( sHead.uiMagic   == RX_CACHE_MAGIC   &&
+                    sHead.uiVersion == RX_CACHE_VERSION &&
+                    sHead.iCsvSize  == iCsvSize  &&
+                    sHead.iCsvMTime == iCsvMTime &&
+                    sHead.uiFCnt    > 0 &&
+                    (quint64)iSize  == ulExpect &&
+                    sHead.ulCsvHash == gulCsvHash );
+
+    if(bValid)
+    {
+        const char *pcStr = pcData + sizeof(RX_CACHE_HEAD);
+
+        /* 站点信息 */
+        QList<QByteArray> aoStr = QByteArray(pcStr, sHead.uiStrBytes).split('\0');
+
+        if(aoStr.count() >= 3)
+        {
+            goStrLineId  = QString::fromUtf8(aoStr.at(0));
+            goStrSiteId  = QString::fromUtf8(aoStr.at(1));
+            goStrCompTag = QString::fromUtf8(aoStr.at(2));
+        }
+
+        giDevId = sHead.iDevId;
+        giDevCh = sHead.iDevCh;
+
+        giParsedEnd = sHead.iParsedEnd;
+
+        const double *pdF   = (const double *)(pcStr + sHead.uiStrBytes);
+        const double *pdAvg = pdF   + ulFCnt;
+        const double *pdErr = pdAvg + ulFCnt;
+
+        const qint64 *piRowPos = (const qint64 *)(pdErr + ulFCnt);
+        const qint64 *piRowLen = piRowPos + ulFCnt;
+        const qint64 *piCnt    = piRowLen + ulFCnt;
+
+        /* 散点不读入，只记下每个频点在缓存文件中的位置 */
+        qint64 iScatterBase = (const char *)(piCnt + ulFCnt) - pcData;
+
+        adF.resize(ulFCnt);
+        adAvg.resize(ulFCnt);
+        adErr.resize(ulFCnt);
+        aiRowPos.resize(ulFCnt);
+        aiRowLen.resize(ulFCnt);
+        aiScatterPos.resize(ulFCnt);
+        aiScatterCnt.resize(ulFCnt);
+        aiCachePos.resize(ulFCnt);
+        abPinned.fill(false, ulFCnt);
+
+        memcpy(adF.data(),      pdF,      ulFCnt*sizeof(double));
+        memcpy(adAvg.data(),    pdAvg,    ulFCnt*sizeof(double));
+        memcpy(adErr.data(),    pdErr,    ulFCnt*sizeof(double));
+        memcpy(aiRowPos.data(), piRowPos, ulFCnt*sizeof(qint64));
+
+        quint64 ulUsed = 0;
+
+        for(quint64 i = 0; i < ulFCnt; i++)
+        {
+            if(piCnt[i] < 0 || ulUsed + piCnt[i] > sHead.ulSampleCnt ||
+                    (i > 0 && !(pdF[i - 1] < pdF[i])))
             {
+                bValid = false;
                 break;
             }
+
+            aiRowLen[i] = piRowLen[i];
+
+            aiScatterPos[i] = -1;
+            aiScatterCnt[i] = piCnt[i];
+
+            aiCachePos[i] = iScatterBase + ulUsed*sizeof(double);
+
+            ulUsed += piCnt[i];
+        }
+
+        if(bValid)
+        {
+            adScatterBuf.clear();
+
+            giScatterHole = 0;
+
+            gulCacheHash = sHead.ulCsvHash;
+        }
+        else
+        {
+            qDebugV5()<<"Corrupt cache:"<<oFile.fileName();
+
+            adF.clear();
+            adAvg.clear();
+            adErr.clear();
+            aiRowPos.clear();
+            aiRowLen.clear();
+            aiScatterPos.clear();
+            aiScatterCnt.clear();
+            aiCachePos.clear();
+            abPinned.clear();
         }
     }
 
+    oFile.unmap(pucData);
     oFile.close();
+
+    return bValid;
 }
 
-/* 刷新散点图，同时，平均值和相对均方误差也应该对应刷新。 */
-void RX::renewScatter(double dF)
+/************************************************************************
+ * 解析完文本后写二进制缓存。先写临时文件再替换，中途失败不会留下半个缓存；
+ * 目录不可写时只记录日志。
+ * 要求全部散点都在adScatterBuf中(gbHoldScatter)，写成功后记下各频点在缓存中的位置。
+ */
+void RX::saveCache(qint64 iCsvSize, qint64 iCsvMTime)
 {
-    /*  */
-    QFile oFile(oStrCSV);
-    QString oStrLineCSV;
-    oStrLineCSV.clear();
+    QByteArray aoStr;
+    aoStr.append(goStrLineId.toUtf8()).append('\0');
+    aoStr.append(goStrSiteId.toUtf8()).append('\0');
+    aoStr.append(goStrCompTag.toUtf8()).append('\0');
 
-    if(oFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    while(aoStr.size() % 8 != 0)
     {
-        QTextStream oStream(&oFile);
+        aoStr.append('\0');
+    }
 
-        oStream.seek(0);
+    qint32 iFCnt = adF.count();
 
-        QStringList aoStrLineCSV;
-        aoStrLineCSV.clear();
+    QVector<qint64> aiLen(iFCnt), aiCnt(iFCnt);
 
-        QString oStrLineCSV;
-        oStrLineCSV.clear();
+    /* 散点在缓存中按频点顺序首尾相接，adScatterBuf中是文件行的顺序，逐个频点写 */
+    quint64 ulSampleCnt = 0;
 
-        while(!oStream.atEnd())
+    for(qint32 i = 0; i < iFCnt; i++)
+    {
+        if(aiScatterPos.at(i) < 0)
         {
-            oStrLineCSV = oStream.readLine();
+            qDebugV5()<<oStrCSV<<"scatter not held, cache not written.";
+            return;
+        }
 
-            if(!oStrLineCSV.isEmpty())
-            {
-                aoStrLineCSV.clear();
+        aiLen[i] = aiRowLen.at(i);
+        aiCnt[i] = aiScatterCnt.at(i);
+
+        ulSampleCnt += aiCnt.at(i);
+    }
+
+    quint64 ulCsvHash = gulCsvHash;
 
-                aoStrLineCSV = oStrLineCSV.split(',', QString::SkipEmptyParts);
+    RX_CACHE_HEAD sHead;
+    memset(&sHead, 0, sizeof(sHead));
 
-                double dCurrentLineF = aoStrLineCSV.first().toDouble();
+    sHead.uiMagic     = RX_CACHE_MAGIC;
+    sHead.uiVersion   = RX_CACHE_VERSION;
+    sHead.iCsvSize    = iCsvSize;
+    sHead.iCsvMTime   = iCsvMTime;
+    sHead.ulCsvHash   = ulCsvHash;
+    sHead.iParsedEnd  = giParsedEnd;
+    sHead.iDevId      = giDevId;
+    sHead.iDevCh      = giDevCh;
+    sHead.uiFCnt      = iFCnt;
+    sHead.uiStrBytes  = aoStr.size();
+    sHead.ulSampleCnt = ulSampleCnt;
 
-                if(dCurrentLineF == dF)
-                {
-                    aoStrLineCSV.removeFirst();
+    QSaveFile oFile(oStrCSV + RX_CACHE_SUFFIX);
 
-                    QVector<double> adScatter;
-                    adScatter.clear();
+    if(!oFile.open(QIODevice::WriteOnly))
+    {
+        qDebugV5()<<oFile.fileName()<<oFile.errorString();
+        return;
+    }
 
-                    foreach(QString oStrData, aoStrLineCSV)
-                    {
-                        adScatter.append(oStrData.toDouble());
-                    }
+    oFile.write((const char *)&sHead, sizeof(sHead));
+    oFile.write(aoStr);
+    oFile.write((const char *)adF.constData(),      iFCnt*sizeof(double));
+    oFile.write((const char *)adAvg.constData(),    iFCnt*sizeof(double));
+    oFile.write((const char *)adErr.constData(),    iFCnt*sizeof(double));
+    oFile.write((const char *)aiRowPos.constData(), iFCnt*sizeof(qint64));
+    oFile.write((const char *)aiLen.constData(),    iFCnt*sizeof(qint64));
+    oFile.write((const char *)aiCnt.constData(),    iFCnt*sizeof(qint64));
 
-                    mapScatterList.remove(dF);
-                    mapScatterList.insert(dF, adScatter);
+    for(qint32 i = 0; i < iFCnt; i++)
+    {
+        oFile.write((const char *)(adScatterBuf.constData() + aiScatterPos.at(i)), aiCnt.at(i)*sizeof(double));
+    }
 
-                    mapAvg.remove(dF);
-                    mapAvg.insert(dF, getAvg(adScatter));
+    if(!oFile.commit())
+    {
+        qDebugV5()<<oFile.fileName()<<oFile.errorString();
+        return;
+    }
 
-                    mapErr.remove(dF);
-                    mapErr.insert(dF, getErr(adScatter));
+    qint64 iScatterBase = sizeof(RX_CACHE_HEAD) + aoStr.size() + (qint64)iFCnt*6*sizeof(double);
 
-                    break;
-                }
+    for(qint32 i = 0; i < iFCnt; i++)
+    {
+        aiCachePos[i] = iScatterBase;
+
+        iScatterBase += aiCnt.at(i)*sizeof(double);
+    }
+
+    gulCacheHash = ulCsvHash;
+}
+
+/************************************************************************
+ * 文件内容hash(FNV-1a，按8字节分块)，用于判断文件内容是否变化
+ */
+quint64 RX::hashBytes(const char *pcData, qint64 iSize)
+{
+    const quint64 ulPrime = Q_UINT64_C(1099511628211);
+
+    quint64 ulHash = Q_UINT64_C(14695981039346656037);
+
+    qint64 i = 0;
+
+    for(; i + 8 <= iSize; i += 8)
+    {
+        quint64 ulWord;
+        memcpy(&ulWord, pcData + i, 8);
+
+        ulHash ^= ulWord;
+        ulHash *= ulPrime;
+        ulHash ^= ulHash >> 32;
+    }
+
+    for(; i < iSize; i++)
+    {
+        ulHash ^= (uchar)pcData[i];
+        ulHash *= ulPrime;
+    }
+
+    return ulHash ^ (quint64)iSize;
+}
+
+/************************************************************************
+ * 解析csv内容：每行 "频率,散点1,散点2,..."
+ * 1：兼容CRLF和LF换行(CsvReader)
+ * 2：空字段跳过(与原来的SkipEmptyParts一致)，行尾的逗号不影响
+ * 3：一次性导入时遇到空行即结束；追加(bTail)模式下跳过空行，
+ *    且不解析还没写完(没有换行符)的最后一行
+ * iBase为pcBegin在文件中的偏移。返回值为下次追加读取的起始位置(文件偏移)：
+ * 没有换行符的最后一行即使已解析，也从它的行首开始重读。
+ * 频率解析不了的行忽略，行号记在调试信息中。
+ * padNewF不为NULL时，记下本次解析到的频点。
+ */
+qint64 RX::parseRX(const char *pcBegin, const char *pcEnd, qint64 iBase, bool bTail, QVector<double> *padNewF)
+{
+    /* 追加读取时不知道起始行号，报错用文件偏移 */
+    CsvReader oReader(pcBegin, pcEnd, iBase, (iBase == 0) ? 1 : 0);
+
+    /* 逐行复用，避免每行分配 */
+    double dF = 0;
+
+    QVector<double> adScatter;
+
+    /* 最后一行可能还在写，追加模式下不取没有换行符的行 */
+    while(oReader.readLine(bTail))
+    {
+        if(oReader.isEmptyLine())
+        {
+            if(bTail)
+            {
+                continue;
             }
+
+            break;
         }
+
+        if(!parseRow(oReader.lineBegin(), oReader.lineEnd(), &dF, &adScatter))
+        {
+            oReader.error("频率无法解析，此行忽略");
+            continue;
+        }
+
+        /* 同时记下这一行在文件中的位置，恢复时直接定位；
+         * 同一频点重新写入(如追加模式下补全的最后一行)时只更新数据 */
+        this->setRow(dF, adScatter, oReader.lineOffset(), oReader.lineEnd() - oReader.lineBegin());
+
+        if(padNewF != NULL)
+        {
+            padNewF->append(dF);
+        }
+
+        if(!oReader.lineHasEol())
+        {
+            this->reportErrors(oReader);
+
+            return oReader.lineOffset();
+        }
+    }
+
+    this->reportErrors(oReader);
+
+    return oReader.pos();
+}
+
+/* 解析中遇到的格式错误写到调试信息，最多列出前10条 */
+void RX::reportErrors(const CsvReader &oReader)
+{
+    if(oReader.errorCount() == 0)
+    {
+        return;
+    }
+
+    qDebugV5()<<oStrCSV<<"malformed lines:"<<oReader.errorCount();
+
+    foreach(QString oStrErr, oReader.errors().mid(0, 10))
+    {
+        qDebugV5()<<oStrErr;
+    }
+}
+
+/************************************************************************
+ * 追加读取：文件还在被采集软件写入时，只解析上次之后新写入的完整行，
+ * 更新对应频点，并发出SigAppended。文件变短(被重写)时从头重读。
+ */
+QVector<double> RX::tail()
+{
+    QVector<double> adNewF;
+
+    QFile oFile(oStrCSV);
+
+    if(!oFile.open(QIODevice::ReadOnly))
+    {
+        qDebugV5()<<oStrCSV<<oFile.errorString();
+        return adNewF;
+    }
+
+    qint64 iSize = oFile.size();
+
+    if(iSize < giParsedEnd)
+    {
+        qDebugV5()<<oStrCSV<<"shrank, re-read from the beginning.";
+        giParsedEnd = 0;
+    }
+
+    if(iSize > giParsedEnd && oFile.seek(giParsedEnd))
+    {
+        QByteArray aoNew = oFile.read(iSize - giParsedEnd);
+
+        giParsedEnd = this->parseRX(aoNew.constData(), aoNew.constData() + aoNew.size(), giParsedEnd, true, &adNewF);
     }
 
     oFile.close();
+
+    if(!adNewF.isEmpty())
+    {
+        emit SigAppended(this, adNewF);
+    }
+
+    return adNewF;
+}
+
+/************************************************************************
+ * 解析一行(不含换行符)：第一个字段为频率，其余为散点
+ */
+bool RX::parseRow(const char *pcLine, const char *pcLineEnd, double *pdF, QVector<double> *padScatter)
+{
+    bool bFirst = true;
+
+    bool bOkF = false;
+
+    *pdF = 0;
+
+    padScatter->clear();
+    padScatter->reserve( (pcLineEnd - pcLine)/8 );
+
+    const char *pcField = pcLine;
+
+    while(pcField <= pcLineEnd)
+    {
+        const char *pcComma = (const char *)memchr(pcField, ',', pcLineEnd - pcField);
+
+        if(pcComma == NULL)
+        {
+            pcComma = pcLineEnd;
+        }
+
+        if(pcComma != pcField)
+        {
+            double dValue = 0;
+
+            /* 散点解析失败按0处理，与QString::toDouble一致 */
+            bool bOk = CsvReader::parseDouble(pcField, pcComma, &dValue);
+
+            if(!bOk)
+            {
+                dValue = 0;
+            }
+
+            if(bFirst)
+            {
+                *pdF = dValue;
+                bOkF = bOk;
+                bFirst = false;
+            }
+            else
+            {
+                padScatter->append(dValue);
+            }
+        }
+
+        pcField = pcComma + 1;
+    }
+
+    return bOkF;
+}
+
+/* 刷新散点图，同时，平均值和相对均方误差也应该对应刷新。
+ * 按导入时记下的位置直接读这一个频点(二进制缓存或csv中的行)，
+ * 耗时与该行在文件中的位置无关。 */
+void RX::renewScatter(double dF)
+{
+    int iIdx = this->indexOf(dF);
+
+    if(iIdx == -1)
+    {
+        qDebugV5()<<"No row index for"<<dF<<"Hz in"<<oStrCSV;
+        return;
+    }
+
+    QVector<double> adScatter;
+
+    if(!this->readRow(iIdx, &adScatter))
+    {
+        return;
+    }
+
+    /* 恢复成文件中的数据，不再常驻内存；缓存中的位置仍然有效 */
+    qint64 iCachePos = aiCachePos.at(iIdx);
+
+    this->setRow(dF, adScatter, aiRowPos.at(iIdx), aiRowLen.at(iIdx));
+
+    aiCachePos[iIdx] = iCachePos;
 }
 
-/* 计算场值平均值 */
-double RX::getAvg(QVector<double> adData)
+/* 读第iIdx个频点的散点：二进制缓存优先，不行再读csv中的那一行 */
+bool RX::readRow(int iIdx, QVector<double> *padScatter) const
 {
-    double dAverage = 0;
-    double dSum = 0;
+    if(aiCachePos.at(iIdx) >= 0 && this->readCacheRow(iIdx, padScatter))
+    {
+        return true;
+    }
 
-    foreach(double dData, adData)
+    qint64 iRowPos = aiRowPos.at(iIdx);
+    qint32 iRowLen = aiRowLen.at(iIdx);
+
+    if(iRowPos < 0)
     {
-        dSum += dData;
+        qDebugV5()<<"No row index for"<<adF.at(iIdx)<<"Hz in"<<oStrCSV;
+        return false;
     }
 
-    if(adData.count() != 0)
+    QFile oFile(oStrCSV);
+
+    if(!oFile.open(QIODevice::ReadOnly) || !oFile.seek(iRowPos))
+    {
+        qDebugV5()<<oStrCSV<<oFile.errorString();
+        return false;
+    }
+
+    QByteArray aoRow = oFile.read(iRowLen);
+
+    oFile.close();
+
+    double dCurrentLineF = 0;
+
+    parseRow(aoRow.constData(), aoRow.constData() + aoRow.size(), &dCurrentLineF, padScatter);
+
+    /* 导入之后文件被改动过，索引已失效 */
+    if(aoRow.size() != iRowLen || dCurrentLineF != adF.at(iIdx))
     {
-        dAverage = dSum/adData.count();
+        qDebugV5()<<oStrCSV<<"changed since import, row index of"<<adF.at(iIdx)<<"Hz is stale.";
+        return false;
     }
 
-    return dAverage;
+    return true;
 }
 
-/* 计算相对均方误差 */
-double RX::getErr(QVector<double> adData)
+/* 从二进制缓存读散点，缓存文件被重写(对应的csv内容hash变了)时返回false */
+bool RX::readCacheRow(int iIdx, QVector<double> *padScatter) const
 {
-    double dError = 0;
+    QFile oFile(oStrCSV + RX_CACHE_SUFFIX);
 
-    double dAvg = 0;
-    dAvg = this->getAvg(adData);
+    if(!oFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    RX_CACHE_HEAD sHead;
+
+    qint32 iCnt = aiScatterCnt.at(iIdx);
 
-    double dTemp = 0 ;
+    bool bValid = ( oFile.read((char *)&sHead, sizeof(sHead)) == sizeof(sHead) &&
+                    sHead.uiMagic   == RX_CACHE_MAGIC   &&
+                    sHead.uiVersion == RX_CACHE_VERSION &&
+                    sHead.ulCsvHash == gulCacheHash &&
+                    aiCachePos.at(iIdx) + (qint64)iCnt*(qint64)sizeof(double) <= oFile.size() &&
+                    oFile.seek(aiCachePos.at(iIdx)) );
 
-    for(qint32 i = 0 ; i < adData.count(); i++)
+    if(bValid)
     {
-        dTemp += qPow((adData.at(i) - dAvg)/dAvg, 2);
+        padScatter->resize(iCnt);
+
+        qint64 iBytes = (qint64)iCnt*sizeof(double);
+
+        bValid = (iCnt == 0 || oFile.read((char *)padScatter->data(), iBytes) == iBytes);
     }
 
-    dError = qSqrt(dTemp/adData.count()) * 100;
+    oFile.close();
 
-    return dError;
+    if(!bValid)
+    {
+        qDebugV5()<<oFile.fileName()<<"does not match, read"<<adF.at(iIdx)<<"Hz from csv.";
+    }
+
+    return bValid;
 }
 
 /***********************************************************
@@ -217,12 +825,245 @@ double RX::getErr(QVector<double> adData)
  */
 void RX::updateScatter(double dF, QVector<double> adScatter)
 {
-    mapScatterList.remove(dF);
-    mapScatterList.insert(dF, adScatter);
+    this->setRow(dF, adScatter);
+}
+
+/* 频点的序号，adF升序，二分查找 */
+int RX::indexOf(double dF) const
+{
+    QVector<double>::const_iterator it = std::lower_bound(adF.constBegin(), adF.constEnd(), dF);
 
-    mapAvg.remove(dF);
-    mapAvg.insert(dF, this->getAvg(adScatter));//adE[dF] = this->getE(adScatter);
+    if(it == adF.constEnd() || *it != dF)
+    {
+        return -1;
+    }
+
+    return it - adF.constBegin();
+}
+
+double RX::avg(double dF) const
+{
+    int iIdx = this->indexOf(dF);
+
+    return (iIdx == -1) ? 0 : adAvg.at(iIdx);
+}
+
+double RX::err(double dF) const
+{
+    int iIdx = this->indexOf(dF);
+
+    return (iIdx == -1) ? 0 : adErr.at(iIdx);
+}
 
-    mapErr.remove(dF);
-    mapErr.insert(dF, this->getErr(adScatter));// adErr[dF] = this->getErr(adScatter);
+/* 频点的散点：常驻的直接取；否则先查LRU缓存，没有再从文件读，读到的放进LRU缓存 */
+QVector<double> RX::scatter(double dF) const
+{
+    QVector<double> adScatter;
+
+    int iIdx = this->indexOf(dF);
+
+    if(iIdx == -1 || aiScatterCnt.at(iIdx) == 0)
+    {
+        return adScatter;
+    }
+
+    if(aiScatterPos.at(iIdx) >= 0)
+    {
+        adScatter.resize(aiScatterCnt.at(iIdx));
+
+        memcpy(adScatter.data(), adScatterBuf.constData() + aiScatterPos.at(iIdx), adScatter.count()*sizeof(double));
+
+        return adScatter;
+    }
+
+    QPair<int, double> oKey(giSerial, dF);
+
+    {
+        QMutexLocker oLocker(&goScatterLruMutex);
+
+        QVector<double> *padCached = goScatterLru.object(oKey);
+
+        if(padCached != NULL)
+        {
+            return *padCached;
+        }
+    }
+
+    /* 读文件时不占着锁，其它线程可以同时取散点 */
+    if(!this->readRow(iIdx, &adScatter))
+    {
+        return QVector<double>();
+    }
+
+    QMutexLocker oLocker(&goScatterLruMutex);
+
+    goScatterLru.insert(oKey, new QVector<double>(adScatter), qMax(1, (int)((adScatter.count()*sizeof(double) + 1023)/1024)));
+
+    return adScatter;
+}
+
+/****************************************************************
+ * 写入一个频点：
+ * 1：新频点，按升序插入各列
+ * 2：来自csv(iRowPos >= 0)且不暂存时，只算平均值和误差，散点不留在内存中，以后按需重读
+ * 3：否则散点存入缓冲区：不比原来多(裁剪后保存)时原地覆盖，否则接在末尾，原来的位置作废
+ */
+void RX::setRow(double dF, const QVector<double> &adScatter, qint64 iRowPos, qint32 iRowLen)
+{
+    QVector<double>::iterator it = std::lower_bound(adF.begin(), adF.end(), dF);
+
+    int iIdx = it - adF.begin();
+
+    qint32 iCnt = adScatter.count();
+
+    bool bNew = (it == adF.end() || *it != dF);
+
+    if(bNew)
+    {
+        adF.insert(iIdx, dF);
+        adAvg.insert(iIdx, 0);
+        adErr.insert(iIdx, 0);
+        aiRowPos.insert(iIdx, -1);
+        aiRowLen.insert(iIdx, 0);
+        aiCachePos.insert(iIdx, -1);
+        abPinned.insert(iIdx, false);
+
+        aiScatterPos.insert(iIdx, -1);
+        aiScatterCnt.insert(iIdx, 0);
+    }
+
+    if(iRowPos < 0 || gbHoldScatter)
+    {
+        if(aiScatterPos.at(iIdx) >= 0 && iCnt <= aiScatterCnt.at(iIdx))
+        {
+            giScatterHole += aiScatterCnt.at(iIdx) - iCnt;
+        }
+        else
+        {
+            if(aiScatterPos.at(iIdx) >= 0)
+            {
+                giScatterHole += aiScatterCnt.at(iIdx);
+            }
+
+            aiScatterPos[iIdx] = adScatterBuf.count();
+
+            adScatterBuf.resize(adScatterBuf.count() + iCnt);
+        }
+
+        aiScatterCnt[iIdx] = iCnt;
+
+        if(iCnt > 0)
+        {
+            memcpy(adScatterBuf.data() + aiScatterPos.at(iIdx), adScatter.constData(), iCnt*sizeof(double));
+        }
+
+        Stats::meanRelErr(adScatterBuf.constData() + aiScatterPos.at(iIdx), iCnt, &adAvg[iIdx], &adErr[iIdx]);
+    }
+    else
+    {
+        if(aiScatterPos.at(iIdx) >= 0)
+        {
+            giScatterHole += aiScatterCnt.at(iIdx);
+        }
+
+        aiScatterPos[iIdx] = -1;
+        aiScatterCnt[iIdx] = iCnt;
+
+        Stats::meanRelErr(adScatter.constData(), iCnt, &adAvg[iIdx], &adErr[iIdx]);
+    }
+
+    if(iRowPos >= 0)
+    {
+        /* 行变了，缓存中的散点不再对应 */
+        aiRowPos[iIdx] = iRowPos;
+        aiRowLen[iIdx] = iRowLen;
+        aiCachePos[iIdx] = -1;
+        abPinned[iIdx] = false;
+    }
+    else
+    {
+        abPinned[iIdx] = true;
+    }
+
+    /* LRU缓存中的旧散点作废；新频点不可能在缓存中，导入时不必加锁 */
+    if(!bNew)
+    {
+        QMutexLocker oLocker(&goScatterLruMutex);
+
+        goScatterLru.remove(QPair<int, double>(giSerial, dF));
+    }
+
+    if(giScatterHole > 4096 && giScatterHole > adScatterBuf.count()/2)
+    {
+        this->compactScatter();
+    }
+}
+
+/* 重排散点缓冲区：按频点顺序首尾相接，去掉作废的部分 */
+void RX::compactScatter()
+{
+    if(giScatterHole == 0)
+    {
+        return;
+    }
+
+    QVector<double> adBuf;
+    adBuf.reserve(adScatterBuf.count() - giScatterHole);
+
+    for(int i = 0; i < adF.count(); i++)
+    {
+        if(aiScatterPos.at(i) < 0)
+        {
+            continue;
+        }
+
+        qint64 iPos = adBuf.count();
+
+        adBuf.resize(iPos + aiScatterCnt.at(i));
+
+        if(aiScatterCnt.at(i) > 0)
+        {
+            memcpy(adBuf.data() + iPos, adScatterBuf.constData() + aiScatterPos.at(i), aiScatterCnt.at(i)*sizeof(double));
+        }
+
+        aiScatterPos[i] = iPos;
+    }
+
+    adScatterBuf = adBuf;
+
+    giScatterHole = 0;
+}
+
+/* 导入完成后丢掉可以从文件重读的散点，缓冲区里只留手动修改过的频点 */
+void RX::releaseScatter()
+{
+    for(int i = 0; i < adF.count(); i++)
+    {
+        if(aiScatterPos.at(i) >= 0 && !abPinned.at(i))
+        {
+            giScatterHole += aiScatterCnt.at(i);
+
+            aiScatterPos[i] = -1;
+        }
+    }
+
+    this->compactScatter();
+
+    adScatterBuf.squeeze();
+}
+
+/* 本对象常驻内存的数据(字节)，按各数组已分配的容量计 */
+qint64 RX::memoryBytes() const
+{
+    return sizeof(RX) +
+            (qint64)adF.capacity()*sizeof(double) +
+            (qint64)adAvg.capacity()*sizeof(double) +
+            (qint64)adErr.capacity()*sizeof(double) +
+            (qint64)aiScatterPos.capacity()*sizeof(qint64) +
+            (qint64)aiScatterCnt.capacity()*sizeof(qint32) +
+            (qint64)adScatterBuf.capacity()*sizeof(double) +
+            (qint64)abPinned.capacity()*sizeof(bool) +
+            (qint64)aiCachePos.capacity()*sizeof(qint64) +
+            (qint64)aiRowPos.capacity()*sizeof(qint64) +
+            (qint64)aiRowLen.capacity()*sizeof(qint32);
 }
@@ -13,25 +13,82 @@
 
 #include <QTextStream>
 
+#include <QCache>
+
+#include <QMutex>
+
+#include <QAtomicInt>
+
 #include "Common/PublicDef.h"
 
+class CsvReader;
+
 class RX : public QObject
 {
     Q_OBJECT
 public:
     explicit RX(QString oStrFileName, QObject *parent = 0);
 
+    ~RX();
+
     /* csv 文件名 */
     QString oStrCSV;
 
+    /* 导入失败的原因，成功时为空 */
+    QString oStrErr;
+
+    /**********************************************************************
+     * 列式存储，所有数组按频率升序一一对应。
+     * 平均值和误差常驻内存；散点按需读取：
+     * 1：aiScatterPos[i] >= 0 时，散点在 adScatterBuf 中从该位置起的 aiScatterCnt[i] 个值，
+     *    常驻的只有手动修改过的频点(abPinned，文件中没有)和导入过程中的临时数据
+     * 2：否则从二进制缓存(aiCachePos[i] >= 0)或csv中的行(aiRowPos/aiRowLen)读取，
+     *    读到的放进所有RX共用的LRU缓存，总量不超过 setScatterBudget 设定的上限
+     */
     QVector<double> adF;
 
-    QMap<double, QVector<double> > mapScatterList;
+    QVector<double> adAvg;
+
+    QVector<double> adErr;
+
+    QVector<qint64> aiScatterPos;
+
+    QVector<qint32> aiScatterCnt;
+
+    QVector<double> adScatterBuf;
+
+    QVector<bool> abPinned;
+
+    /* 散点在二进制缓存文件中的字节偏移，没有时为-1 */
+    QVector<qint64> aiCachePos;
 
-    QMap<double, double> mapAvg;
+    /* 每个频点所在行在csv文件中的字节偏移和长度 */
+    QVector<qint64> aiRowPos;
 
-    QMap<double, double> mapErr;
+    QVector<qint32> aiRowLen;
 
+    /* 频点的序号(二分查找)，没有返回-1 */
+    int indexOf(double dF) const;
+
+    double avg(double dF) const;
+
+    double err(double dF) const;
+
+    QVector<double> scatter(double dF) const;
+
+    /* 写入(新增或替换)一个频点的散点，同时更新平均值和误差。
+     * iRowPos >= 0：数据来自csv的这一行，散点以后可按需重读；
+     * iRowPos < 0 ：手动修改的数据，保留原来的行位置，散点常驻内存 */
+    void setRow(double dF, const QVector<double> &adScatter, qint64 iRowPos = -1, qint32 iRowLen = 0);
+
+    /* 本对象常驻内存的数据(字节)，不含LRU缓存中的散点 */
+    qint64 memoryBytes() const;
+
+    /* 所有RX共用的散点LRU缓存上限(MB)，默认64MB */
+    static void setScatterBudget(int iMB);
+
+    /* LRU缓存中散点占用的内存(字节) */
+    static qint64 scatterCacheBytes();
 
     QString goStrLineId, goStrSiteId;
 
@@ -39,18 +96,83 @@ public:
 
     QString goStrCompTag;
 
-    void importRX(QString oStrFileName);
+    bool importRX(QString oStrFileName);
+
+    /* 从文件名中取线号/点号/仪器号/通道号/分量，格式不对返回false */
+    static bool parseFileName(QString oStrFileName, QString *poStrLineId, QString *poStrSiteId,
+                              int *piDevId, int *piDevCh, QString *poStrCompTag);
+
+    /* 文件内容哈希，用于识别拷贝到不同目录的同一文件 */
+    static quint64 hashFile(QString oStrFileName);
+
+    /* 是否使用二进制缓存文件(csv同目录下的 .rxc)，默认开启 */
+    static bool gbUseCache;
+
+    /* 缓存与csv(大小、修改时间、内容hash)一致时，从缓存读入 */
+    bool loadCache(qint64 iCsvSize, qint64 iCsvMTime);
+
+    /* 解析完文本后写缓存 */
+    void saveCache(qint64 iCsvSize, qint64 iCsvMTime);
+
+    /* 文件内容hash */
+    static quint64 hashBytes(const char *pcData, qint64 iSize);
+
+    /* 导入时csv的内容hash，缓存校验和项目中判断文件是否改过都用它 */
+    quint64 gulCsvHash;
+
+    /* 当前二进制缓存对应的csv内容hash，按需读取散点时确认缓存文件没有被重写 */
+    quint64 gulCacheHash;
+
+    /* 直接在文件映射的字节上解析频率与散点，不经过QString/QStringList */
+    qint64 parseRX(const char *pcBegin, const char *pcEnd, qint64 iBase = 0, bool bTail = false, QVector<double> *padNewF = NULL);
+
+    /* 已解析到的文件位置，追加读取从这里开始 */
+    qint64 giParsedEnd;
+
+    /* 追加读取：只解析新写入的行，返回本次更新的频点 */
+    QVector<double> tail();
+
+    /* 解析一行：频率 + 散点，频率解析不了时返回false */
+    static bool parseRow(const char *pcLine, const char *pcLineEnd, double *pdF, QVector<double> *padScatter);
 
     /* 工具选定的频率，更新Rx类中的变量。原来是工具index来检索，有一定的耦合性，所以改过来了。 */
     void renewScatter(double dF);
 
-    double getAvg(QVector<double> adData);
+    void updateScatter(double dF, QVector<double> adScatter);
+
+private:
+    /* adScatterBuf中已废弃(被替换掉)的值的个数 */
+    qint64 giScatterHole;
 
-    double getErr(QVector<double> adData);
+    /* 废弃的值过多时，重排adScatterBuf */
+    void compactScatter();
 
-    void updateScatter(double dF, QVector<double> adScatter);
+    /* 为true时(导入并写缓存期间)，来自文件的散点也暂存在adScatterBuf中 */
+    bool gbHoldScatter;
+
+    /* 丢掉adScatterBuf中可以重读的散点，只留手动修改过的 */
+    void releaseScatter();
+
+    /* 从csv/二进制缓存读第iIdx个频点的散点 */
+    bool readRow(int iIdx, QVector<double> *padScatter) const;
+
+    bool readCacheRow(int iIdx, QVector<double> *padScatter) const;
+
+    /* 本对象在LRU缓存中的编号，不用指针，避免对象释放后地址被复用 */
+    int giSerial;
+
+    static QAtomicInt goSerialNext;
+
+    /* 散点LRU缓存：键为(giSerial, 频率)，cost单位为KB */
+    static QCache<QPair<int, double>, QVector<double> > goScatterLru;
+
+    static QMutex goScatterLruMutex;
+
+    void reportErrors(const CsvReader &oReader);
 
 signals:
+    /* 追加读取到了新的频点 */
+    void SigAppended(RX *, QVector<double>);
 
 public slots:
 };
@@ -8,6 +8,8 @@ QT       += core gui
 
 QT       += sql
 
+QT       += concurrent
+
 CONFIG   += C++11
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
@@ -24,7 +26,14 @@ SOURCES += main.cpp \
     Picker/MarkerPicker.cpp \
     CalRhoThread.cpp \
     MyDatabase.cpp \
-    CustomTableModel.cpp
+    DbWriter.cpp \
+    CustomTableModel.cpp \
+    Common/Benchmark.cpp \
+    Common/Stats.cpp \
+    Common/CsvReader.cpp \
+    Common/RhoSolver.cpp \
+    Common/Quadrature.cpp \
+    Common/RhoTable.cpp
 
 HEADERS  += \
     Common/PublicDef.h \
@@ -35,7 +44,14 @@ HEADERS  += \
     Picker/MarkerPicker.h \
     CalRhoThread.h \
     MyDatabase.h \
-    CustomTableModel.h
+    DbWriter.h \
+    CustomTableModel.h \
+    Common/Benchmark.h \
+    Common/Stats.h \
+    Common/CsvReader.h \
+    Common/RhoSolver.h \
+    Common/Quadrature.h \
+    Common/RhoTable.h
 
 FORMS    += \
     Mainwindow.ui
@@ -0,0 +1,188 @@
+#include "DbWriter.h"
+
+#include "MyDatabase.h"
+
+/* 写线程的连接名 */
+#define DB_WRITER_CONNECTION    "DbWriter"
+
+DbWriter::DbWriter(QString oStrDbName, QObject *parent) :
+    QObject(parent),
+    goStrDbName(oStrDbName)
+{
+    giDone = 0;
+}
+
+void DbWriter::open(QString oStrSynchronous, int iCacheKB)
+{
+    QSqlDatabase oDb = QSqlDatabase::addDatabase("QSQLITE", DB_WRITER_CONNECTION);
+
+    oDb.setDatabaseName(goStrDbName);
+
+    if(!oDb.open())
+    {
+        qDebugV5()<<oDb.lastError().text();
+        return;
+    }
+
+    QSqlQuery oQuery(oDb);
+
+    if(!oQuery.exec("PRAGMA journal_mode = WAL"))
+    {
+        qDebugV5()<<oQuery.lastError().text();
+    }
+
+    /* 另一个连接正在读写时等待，而不是直接返回SQLITE_BUSY */
+    oQuery.exec("PRAGMA busy_timeout = 5000");
+
+    this->tune(oStrSynchronous, iCacheKB);
+}
+
+/* synchronous：OFF/NORMAL/FULL，WAL下NORMAL不会损坏数据库，只可能丢最后几次提交；
+ * cache_size取负值时单位为KB */
+void DbWriter::tune(QString oStrSynchronous, int iCacheKB)
+{
+    QSqlDatabase oDb = QSqlDatabase::database(DB_WRITER_CONNECTION, false);
+
+    if(!oDb.isOpen())
+    {
+        return;
+    }
+
+    QSqlQuery oQuery(oDb);
+
+    if(!oQuery.exec(QString("PRAGMA synchronous = %1").arg(oStrSynchronous)))
+    {
+        qDebugV5()<<oQuery.lastError().text();
+    }
+
+    if(!oQuery.exec(QString("PRAGMA cache_size = -%1").arg(iCacheKB)))
+    {
+        qDebugV5()<<oQuery.lastError().text();
+    }
+}
+
+void DbWriter::write(DB_WRITE sWrite)
+{
+    QSqlDatabase oDb = QSqlDatabase::database(DB_WRITER_CONNECTION, false);
+
+    bool bOk = oDb.isOpen();
+
+    QString oStrErr = bOk ? QString() : QString("数据库未打开");
+
+    if(bOk)
+    {
+        bOk = execute(oDb, sWrite, &oStrErr);
+    }
+
+    if(!bOk)
+    {
+        qDebugV5()<<sWrite.oStrSql<<oStrErr;
+    }
+
+    this->finish(sWrite.iTicket);
+
+    emit SigWritten(sWrite.iTicket, sWrite.iModel, bOk, oStrErr);
+}
+
+bool DbWriter::execute(QSqlDatabase &oDb, DB_WRITE &sWrite, QString *poStrErr)
+{
+    QSqlQuery oQuery(oDb);
+
+    bool bOk = true;
+
+    oDb.transaction();
+
+    foreach(QString oStrSql, sWrite.aoStrPre)
+    {
+        if(!oQuery.exec(oStrSql))
+        {
+            *poStrErr = oQuery.lastError().text();
+            bOk = false;
+            break;
+        }
+    }
+
+    if(bOk && !sWrite.oStrSql.isEmpty())
+    {
+        oQuery.prepare(sWrite.oStrSql);
+
+        /* 每DB_BATCH_ROWS行绑定执行一次，一次绑定的值不会随导入的行数无限增长 */
+        int iRows = sWrite.aaoColumn.isEmpty() ? 0 : sWrite.aaoColumn.first().count();
+
+        QVector<QVariantList> aaoChunk(sWrite.aaoColumn.count());
+
+        for(int iBegin = 0; bOk && iBegin < iRows; iBegin += DB_BATCH_ROWS)
+        {
+            for(int i = 0; i < aaoChunk.count(); i++)
+            {
+                aaoChunk[i] = sWrite.aaoColumn.at(i).mid(iBegin, DB_BATCH_ROWS);
+            }
+
+            bOk = MyDatabase::execBatch(oQuery, aaoChunk);
+        }
+
+        if(!bOk)
+        {
+            *poStrErr = oQuery.lastError().text();
+        }
+
+        sWrite.aaoColumn.clear();
+    }
+
+    for(int i = 0; bOk && i < sWrite.aoStrPost.count(); i++)
+    {
+        if(!oQuery.exec(sWrite.aoStrPost.at(i)))
+        {
+            *poStrErr = oQuery.lastError().text();
+            bOk = false;
+        }
+    }
+
+    if(bOk)
+    {
+        bOk = oDb.commit();
+
+        if(!bOk)
+        {
+            *poStrErr = oDb.lastError().text();
+        }
+    }
+
+    /* 提交失败时事务仍开着，不回滚的话之后各批都会落在这个事务里，永远不提交 */
+    if(!bOk)
+    {
+        oDb.rollback();
+    }
+
+    return bOk;
+}
+
+void DbWriter::close()
+{
+    {
+        QSqlDatabase oDb = QSqlDatabase::database(DB_WRITER_CONNECTION, false);
+
+        oDb.close();
+    }
+
+    QSqlDatabase::removeDatabase(DB_WRITER_CONNECTION);
+}
+
+void DbWriter::finish(qint64 iTicket)
+{
+    QMutexLocker oLocker(&goMutex);
+
+    giDone = qMax(giDone, iTicket);
+
+    goDone.wakeAll();
+}
+
+void DbWriter::wait(qint64 iTicket)
+{
+    QMutexLocker oLocker(&goMutex);
+
+    while(giDone < iTicket)
+    {
+        goDone.wait(&goMutex);
+    }
+}
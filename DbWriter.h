@@ -0,0 +1,104 @@
+/**********************************************************************
+ * 数据库写线程
+ *
+ * 独占一个到同一数据库文件的连接，在自己的线程中按提交顺序执行写操作。
+ * 数据库为WAL模式：写的同时，GUI线程的连接照常读，读到的是最近一次提交时的快照。
+ */
+#ifndef DBWRITER_H
+#define DBWRITER_H
+
+#include <QObject>
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "Common/PublicDef.h"
+
+/* 写完后刷新哪张表的model */
+#define DB_MODEL_NONE   0
+#define DB_MODEL_TX     1
+#define DB_MODEL_RX     2
+#define DB_MODEL_XY     3
+#define DB_MODEL_RHO    4
+
+/* 不新建model，已有的Rho model重新select一次 */
+#define DB_MODEL_RHO_SELECT 5
+
+/* 一批写操作改了哪些表；读的时候只等改过所读各表的写操作 */
+#define DB_TABLE_TX         0x01
+#define DB_TABLE_RX         0x02
+#define DB_TABLE_XY         0x04
+#define DB_TABLE_RHO        0x08
+#define DB_TABLE_SOURCE     0x10
+#define DB_TABLE_ALL        0x1F
+
+/* DB_TABLE_*的个数 */
+#define DB_TABLE_COUNT      5
+
+/* 一批写操作，整批一个事务：
+ * 先依次执行aoStrPre(不带参数，如DELETE)，再把aaoColumn按列绑定到oStrSql上批量执行，
+ * 最后依次执行aoStrPost(如用临时表中暂存的数据做一次UPDATE) */
+typedef struct _DB_WRITE
+{
+    qint64 iTicket;
+
+    int iModel;
+
+    /* DB_TABLE_*的组合 */
+    int iTables;
+
+    QStringList aoStrPre;
+
+    QString oStrSql;
+
+    QVector<QVariantList> aaoColumn;
+
+    QStringList aoStrPost;
+}DB_WRITE;
+
+Q_DECLARE_METATYPE(DB_WRITE)
+
+class DbWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DbWriter(QString oStrDbName, QObject *parent = 0);
+
+    /* 阻塞直到编号不大于iTicket的写操作都执行完(成功或失败) */
+    void wait(qint64 iTicket);
+
+    /* 在oDb上以一个事务执行sWrite，任一步或提交失败时回滚，原因写入poStrErr */
+    static bool execute(QSqlDatabase &oDb, DB_WRITE &sWrite, QString *poStrErr);
+
+signals:
+    /* 一批写操作执行完 */
+    void SigWritten(qint64 iTicket, int iModel, bool bOk, QString oStrErr);
+
+public slots:
+    /* 在写线程中打开连接并设置WAL、同步级别和页缓存(KB) */
+    void open(QString oStrSynchronous, int iCacheKB);
+
+    void tune(QString oStrSynchronous, int iCacheKB);
+
+    void write(DB_WRITE sWrite);
+
+    void close();
+
+private:
+    QString goStrDbName;
+
+    QMutex goMutex;
+
+    QWaitCondition goDone;
+
+    /* 已执行完的最大编号 */
+    qint64 giDone;
+
+    void finish(qint64 iTicket);
+};
+
+#endif // DBWRITER_H
@@ -1,15 +1,70 @@
 #include "MyDatabase.h"
 
+#include <algorithm>
+
 MyDatabase::MyDatabase(QObject *parent) : QObject(parent)
 {
+    gbTxLoaded = false;
+
+    poDb = NULL;
+
+    poWriter = NULL;
+    poWriterThread = NULL;
+
+    giTicket = 0;
+
+    for(int i = 0; i < DB_TABLE_COUNT; i++)
+    {
+        aiTableTicket[i] = 0;
+    }
 
+    poRhoModel = NULL;
 }
 
-void MyDatabase::connect()
+/* 等排队的写操作都落盘后再停写线程 */
+MyDatabase::~MyDatabase()
 {
-    poDb = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE"));
+    this->closeWriter();
+}
+
+void MyDatabase::closeWriter()
+{
+    if(poWriterThread != NULL)
+    {
+        poWriter->wait(giTicket);
 
-    poDb->setDatabaseName("MyDb.db");
+        QMetaObject::invokeMethod(poWriter, "close", Qt::BlockingQueuedConnection);
+
+        poWriterThread->quit();
+        poWriterThread->wait();
+
+        delete poWriter;
+        delete poWriterThread;
+
+        poWriter = NULL;
+        poWriterThread = NULL;
+    }
+}
+
+/******************************************************************************
+ * 打开项目数据库。数据都保留在项目里，重新打开时各表原样恢复(restore)，
+ * 不再每次启动都清空重算。换项目时，上一个项目排队的写操作先做完。
+ */
+void MyDatabase::connect(QString oStrDbFile)
+{
+    this->closeWriter();
+
+    /* 界面上的model共用这个连接，换项目时只换文件，不重建连接 */
+    if(poDb == NULL)
+    {
+        poDb = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE"));
+    }
+    else
+    {
+        poDb->close();
+    }
+
+    poDb->setDatabaseName(oStrDbFile);
 
     if(!poDb->open())
     {
@@ -17,24 +72,692 @@ void MyDatabase::connect()
     }
     else
     {
-        qDebugV0()<<"connect DB ok!";
+        qDebugV0()<<"connect DB ok!"<<oStrDbFile;
+    }
+
+    if(!migrate(*poDb))
+    {
+        qDebugV5()<<"Migrate DB to version"<<DB_SCHEMA_VERSION<<"failed.";
     }
 
     QSqlQuery oQuery;
 
+    /* WAL模式记在数据库文件中，写线程的连接也一样；读写互不阻塞 */
+    if(!oQuery.exec("PRAGMA journal_mode = WAL"))
+    {
+        qDebugV5()<<oQuery.lastError().text();
+    }
+
+    oQuery.exec("PRAGMA busy_timeout = 5000");
+
+    oQuery.finish();
 
-    if(!oQuery.exec("DELETE FROM RX"))
+    /* 电流表属于项目，换了项目要重读 */
+    {
+        QMutexLocker oLocker(&goTxMutex);
+
+        gbTxLoaded = false;
+
+        adTxMissing.clear();
+    }
+
+    /* 之后的写操作都交给写线程 */
+    qRegisterMetaType<DB_WRITE>("DB_WRITE");
+
+    poWriterThread = new QThread(this);
+
+    poWriter = new DbWriter(poDb->databaseName());
+    poWriter->moveToThread(poWriterThread);
+
+    /* 新的写线程从1开始编号 */
+    giTicket = 0;
+
+    for(int i = 0; i < DB_TABLE_COUNT; i++)
+    {
+        aiTableTicket[i] = 0;
+    }
+
+    QObject::connect(this, SIGNAL(SigWrite(DB_WRITE)), poWriter, SLOT(write(DB_WRITE)));
+    QObject::connect(poWriter, SIGNAL(SigWritten(qint64, int, bool, QString)), this, SLOT(written(qint64, int, bool, QString)));
+
+    poWriterThread->start();
+
+    QMetaObject::invokeMethod(poWriter, "open", Qt::QueuedConnection,
+                              Q_ARG(QString, DB_SYNCHRONOUS), Q_ARG(int, DB_CACHE_KB));
+}
+
+QString MyDatabase::project()
+{
+    return (poDb != NULL) ? poDb->databaseName() : QString();
+}
+
+/* 打开项目后，各表直接从数据库发给界面，不必重新导入 */
+void MyDatabase::restore()
+{
+    this->waitWrites(DB_TABLE_TX | DB_TABLE_RX | DB_TABLE_XY | DB_TABLE_RHO);
+
+    this->emitModel(DB_MODEL_TX);
+    this->emitModel(DB_MODEL_RX);
+    this->emitModel(DB_MODEL_XY);
+    this->emitModel(DB_MODEL_RHO);
+}
+
+/* 清空项目，之后从头导入 */
+void MyDatabase::clearProject()
+{
+    DB_WRITE sWrite;
+
+    sWrite.iModel = DB_MODEL_NONE;
+    sWrite.iTables = DB_TABLE_ALL;
+
+    sWrite.aoStrPre<<"DELETE FROM TX"
+                  <<"DELETE FROM RX"
+                 <<"DELETE FROM Coordinate"
+                <<"DELETE FROM RhoData"
+               <<"DELETE FROM RhoStation"
+              <<"DELETE FROM SourceFile";
+
+    this->submit(sWrite);
+
+    {
+        QMutexLocker oLocker(&goTxMutex);
+
+        gbTxLoaded = false;
+
+        adTxMissing.clear();
+    }
+
+    this->restore();
+}
+
+/* 文件当前的状态，路径统一为绝对路径 */
+SOURCE_FILE MyDatabase::sourceOf(QString oStrFile, quint64 ulHash)
+{
+    QFileInfo oFileInfo(oStrFile);
+
+    SOURCE_FILE sSource;
+
+    sSource.oStrPath = oFileInfo.absoluteFilePath();
+    sSource.iSize    = oFileInfo.size();
+    sSource.iMTime   = oFileInfo.lastModified().toMSecsSinceEpoch();
+    sSource.ulHash   = (ulHash != 0) ? ulHash : RX::hashFile(oStrFile);
+
+    return sSource;
+}
+
+void MyDatabase::recordSource(QString oStrKind, QList<SOURCE_FILE> aoSource, bool bReplace)
+{
+    DB_WRITE sWrite;
+
+    sWrite.iModel = DB_MODEL_NONE;
+    sWrite.iTables = DB_TABLE_SOURCE;
+
+    if(bReplace)
+    {
+        sWrite.aoStrPre<<QString("DELETE FROM SourceFile WHERE Kind = '%1'").arg(oStrKind);
+    }
+
+    /* Path, Kind, Size, MTime, Hash */
+    sWrite.oStrSql = "INSERT OR REPLACE INTO SourceFile VALUES(?, ?, ?, ?, ?)";
+
+    QVector<QVariantList> &aaoColumn = sWrite.aaoColumn;
+    aaoColumn.resize(5);
+
+    foreach(SOURCE_FILE sSource, aoSource)
+    {
+        aaoColumn[0].append(sSource.oStrPath);
+        aaoColumn[1].append(oStrKind);
+        aaoColumn[2].append(sSource.iSize);
+        aaoColumn[3].append(sSource.iMTime);
+        /* SQLite只有有符号整数，按位存 */
+        aaoColumn[4].append((qint64)sSource.ulHash);
+    }
+
+    this->submit(sWrite);
+}
+
+QStringList MyDatabase::getSource(QString oStrKind)
+{
+    this->waitWrites(DB_TABLE_SOURCE);
+
+    QStringList aoStrFile;
+
+    QSqlQuery oQuery;
+    oQuery.prepare("SELECT Path FROM SourceFile WHERE Kind = ? ORDER BY Path");
+    oQuery.addBindValue(oStrKind);
+
+    if(!oQuery.exec())
     {
         qDebugV5()<<oQuery.lastError().text();
     }
-    if(!oQuery.exec("DELETE FROM Coordinate"))
+
+    while(oQuery.next())
+    {
+        aoStrFile.append(oQuery.value(0).toString());
+    }
+
+    return aoStrFile;
+}
+
+/******************************************************************************
+ * 大小和修改时间都与记录一致时认为没变，不读文件；
+ * 有一项不一致时再比内容hash(只是被touch或拷贝过的文件算没变)。
+ */
+int MyDatabase::sourceState(QString oStrFile)
+{
+    this->waitWrites(DB_TABLE_SOURCE);
+
+    QFileInfo oFileInfo(oStrFile);
+
+    QSqlQuery oQuery;
+    oQuery.prepare("SELECT Size, MTime, Hash FROM SourceFile WHERE Path = ?");
+    oQuery.addBindValue(oFileInfo.absoluteFilePath());
+
+    if(!oQuery.exec() || !oQuery.next())
+    {
+        return SOURCE_NEW;
+    }
+
+    if(!oFileInfo.exists())
+    {
+        return SOURCE_MISSING;
+    }
+
+    if(oQuery.value(0).toLongLong() == oFileInfo.size() &&
+            oQuery.value(1).toLongLong() == oFileInfo.lastModified().toMSecsSinceEpoch())
+    {
+        return SOURCE_SAME;
+    }
+
+    if((quint64)oQuery.value(2).toLongLong() == RX::hashFile(oStrFile))
+    {
+        return SOURCE_SAME;
+    }
+
+    return SOURCE_CHANGED;
+}
+
+/* 调整写线程连接的同步级别和页缓存 */
+void MyDatabase::tune(QString oStrSynchronous, int iCacheKB)
+{
+    if(poWriter != NULL)
+    {
+        QMetaObject::invokeMethod(poWriter, "tune", Qt::QueuedConnection,
+                                  Q_ARG(QString, oStrSynchronous), Q_ARG(int, iCacheKB));
+    }
+}
+
+/* 交给写线程排队执行，返回编号；改到的各表记下这个编号 */
+qint64 MyDatabase::submit(DB_WRITE sWrite)
+{
+    QMutexLocker oLocker(&goTicketMutex);
+
+    sWrite.iTicket = ++giTicket;
+
+    for(int i = 0; i < DB_TABLE_COUNT; i++)
+    {
+        if(sWrite.iTables & (1 << i))
+        {
+            aiTableTicket[i] = sWrite.iTicket;
+        }
+    }
+
+    /* 在锁内发出，保证写线程收到的顺序与编号一致 */
+    emit SigWrite(sWrite);
+
+    return sWrite.iTicket;
+}
+
+/* 读之前调用：只等改过所读各表的最后一次写操作，读到的就包含自己刚写的数据；
+ * 其它表还在写时不必等，读连接看到的是WAL中已提交的快照 */
+void MyDatabase::waitWrites(int iTables)
+{
+    if(poWriter == NULL)
+    {
+        return;
+    }
+
+    qint64 iTicket = 0;
+
+    goTicketMutex.lock();
+
+    for(int i = 0; i < DB_TABLE_COUNT; i++)
+    {
+        if((iTables & (1 << i)) && (aiTableTicket[i] > iTicket))
+        {
+            iTicket = aiTableTicket[i];
+        }
+    }
+
+    goTicketMutex.unlock();
+
+    if(iTicket > 0)
+    {
+        poWriter->wait(iTicket);
+    }
+}
+
+/* 表名(不分大小写)对应的DB_TABLE_*，不认识的表按全部表处理 */
+int MyDatabase::tableOf(QString oStrTableName)
+{
+    QString oStrTable = oStrTableName.toLower();
+
+    if(oStrTable == "tx")
+    {
+        return DB_TABLE_TX;
+    }
+    else if(oStrTable == "rx")
+    {
+        return DB_TABLE_RX;
+    }
+    else if(oStrTable == "coordinate")
+    {
+        return DB_TABLE_XY;
+    }
+    else if( (oStrTable == "rho") || (oStrTable == "rhodata") || (oStrTable == "rhostation") )
+    {
+        return DB_TABLE_RHO;
+    }
+    else if(oStrTable == "sourcefile")
+    {
+        return DB_TABLE_SOURCE;
+    }
+
+    return DB_TABLE_ALL;
+}
+
+/* 写线程执行完一批：失败时提示，成功时刷新对应的表 */
+void MyDatabase::written(qint64 iTicket, int iModel, bool bOk, QString oStrErr)
+{
+    if(!bOk)
+    {
+        emit SigMsg(QString("写数据库失败(%1)：\n%2").arg(iTicket).arg(oStrErr));
+        return;
+    }
+
+    this->emitModel(iModel);
+}
+
+/* 新建表的model并发给界面 */
+void MyDatabase::emitModel(int iModel)
+{
+    switch(iModel)
+    {
+    case DB_MODEL_TX:
+    {
+        QSqlTableModel *poModel = new QSqlTableModel(this, *poDb);
+        poModel->setTable("TX");
+        poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
+
+        poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("频率"));
+        poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("电流"));
+        poModel->select();
+
+        emit SigModelTX(poModel);
+    }
+        break;
+    case DB_MODEL_RX:
+    {
+        QSqlTableModel *poModel = new QSqlTableModel(this, *poDb);
+        poModel->setTable("RX");
+        poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
+        poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("线号"));
+        poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("点号"));
+        poModel->setHeaderData(2, Qt::Horizontal, QStringLiteral("仪器号"));
+        poModel->setHeaderData(3, Qt::Horizontal, QStringLiteral("通道号"));
+        poModel->setHeaderData(4, Qt::Horizontal, QStringLiteral("分量标识"));
+        poModel->setHeaderData(5, Qt::Horizontal, QStringLiteral("频率"));
+        poModel->setHeaderData(6, Qt::Horizontal, QStringLiteral("电流"));
+        poModel->setHeaderData(7, Qt::Horizontal, QStringLiteral("场值"));
+        poModel->setHeaderData(8, Qt::Horizontal, QStringLiteral("相对均方误差"));
+        poModel->select();
+
+        emit SigModelRX(poModel);
+    }
+        break;
+    case DB_MODEL_XY:
+    {
+        CustomTableModel *poModel = new CustomTableModel(this, *poDb);
+        poModel->setBoldColumns(-1, -1);
+
+        for(int i = 2; i < 8; i++)
+        {
+            poModel->setColumnFormat(i, FloatPrecision);
+        }
+
+        poModel->setTable("Coordinate");
+        poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
+        poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("线号"));
+        poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("点号"));
+        poModel->setHeaderData(2, Qt::Horizontal, QStringLiteral("MX"));
+        poModel->setHeaderData(3, Qt::Horizontal, QStringLiteral("MY"));
+        poModel->setHeaderData(4, Qt::Horizontal, QStringLiteral("MH"));
+        poModel->setHeaderData(5, Qt::Horizontal, QStringLiteral("NX"));
+        poModel->setHeaderData(6, Qt::Horizontal, QStringLiteral("NY"));
+        poModel->setHeaderData(7, Qt::Horizontal, QStringLiteral("NH"));
+        poModel->select();
+
+        emit SigModelXY(poModel);
+    }
+        break;
+    case DB_MODEL_RHO:
+    {
+        CustomTableModel *poModel = new CustomTableModel(this, *poDb);
+
+        poModel->setTable("Rho");
+
+        poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
+
+        poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("线号"));
+        poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("点号"));
+        poModel->setHeaderData(2, Qt::Horizontal, QStringLiteral("仪器号"));
+        poModel->setHeaderData(3, Qt::Horizontal, QStringLiteral("通道号"));
+        poModel->setHeaderData(4, Qt::Horizontal, QStringLiteral("分量标识"));
+
+        poModel->setHeaderData(5, Qt::Horizontal, QStringLiteral("频率"));
+        poModel->setHeaderData(6, Qt::Horizontal, QStringLiteral("电流"));
+        poModel->setHeaderData(7, Qt::Horizontal, QStringLiteral("场值"));
+        poModel->setHeaderData(8, Qt::Horizontal, QStringLiteral("相对均方误差"));
+        poModel->setHeaderData(9, Qt::Horizontal, QStringLiteral("视电阻率"));
+
+        poModel->setHeaderData(10, Qt::Horizontal, QStringLiteral("AX"));
+        poModel->setHeaderData(11, Qt::Horizontal, QStringLiteral("AY"));
+        poModel->setHeaderData(12, Qt::Horizontal, QStringLiteral("AH"));
+        poModel->setHeaderData(13, Qt::Horizontal, QStringLiteral("BX"));
+        poModel->setHeaderData(14, Qt::Horizontal, QStringLiteral("BY"));
+        poModel->setHeaderData(15, Qt::Horizontal, QStringLiteral("BH"));
+        poModel->setHeaderData(16, Qt::Horizontal, QStringLiteral("MX"));
+        poModel->setHeaderData(17, Qt::Horizontal, QStringLiteral("MY"));
+        poModel->setHeaderData(18, Qt::Horizontal, QStringLiteral("MH"));
+        poModel->setHeaderData(19, Qt::Horizontal, QStringLiteral("NX"));
+        poModel->setHeaderData(20, Qt::Horizontal, QStringLiteral("NY"));
+        poModel->setHeaderData(21, Qt::Horizontal, QStringLiteral("NH"));
+
+        poModel->setHeaderData(22, Qt::Horizontal, QStringLiteral("正演次数"));
+        poModel->setHeaderData(23, Qt::Horizontal, QStringLiteral("相对残差"));
+        poModel->setHeaderData(24, Qt::Horizontal, QStringLiteral("收敛"));
+
+        /* 与原来存成文本时的位数一致 */
+        poModel->setColumnFormat(7, 4);
+        poModel->setColumnFormat(8, 2, "%");
+        poModel->setColumnFormat(9, 0);
+
+        for(int i = 10; i < 22; i++)
+        {
+            poModel->setColumnFormat(i, FloatPrecision);
+        }
+
+        poModel->setColumnFormat(23, 4, "%");
+
+        poModel->select();
+
+        poRhoModel = poModel;
+
+        emit SigModelRho(poModel);
+    }
+        break;
+    case DB_MODEL_RHO_SELECT:
+        /* 表格已经在显示的话，原model重新select，不必新建 */
+        if(poRhoModel != NULL)
+        {
+            poRhoModel->select();
+        }
+        else
+        {
+            this->emitModel(DB_MODEL_RHO);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/************************************************************************
+ * 表结构迁移
+ * 版本1：原来的四张表没有主键也没有索引，按线号/点号/仪器号/通道号/频率查询时全表扫描。
+ *        改为以这些列为主键的WITHOUT ROWID表，数据按主键聚簇存放，
+ *        主键即覆盖索引，按站点(前缀)或站点+频点的查询都只走索引。
+ *        列名和列顺序不变，原有数据拷过去(重复的保留最后一行)。
+ *        旧表不存在(新建的库)时先建出来，迁移步骤不必区分。
+ */
+QStringList MyDatabase::migration(int iVersion)
+{
+    QStringList aoStrSql;
+
+    switch(iVersion)
+    {
+    case 1:
+        aoStrSql<<"CREATE TABLE IF NOT EXISTS TX(F DOUBLE NOT NULL, I DOUBLE)"
+               <<"CREATE TABLE TX_New(F DOUBLE NOT NULL, I DOUBLE, "
+                 "PRIMARY KEY(F)) WITHOUT ROWID"
+              <<"INSERT OR REPLACE INTO TX_New SELECT F, I FROM TX"
+             <<"DROP TABLE TX"
+            <<"ALTER TABLE TX_New RENAME TO TX";
+
+        aoStrSql<<"CREATE TABLE IF NOT EXISTS RX(LineId TEXT, SiteId TEXT, DevId INTEGER, DevCh INTEGER, "
+                  "CompTag TEXT, F DOUBLE, I DOUBLE, Field DOUBLE, Err DOUBLE)"
+               <<"CREATE TABLE RX_New(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                 "DevId INTEGER NOT NULL, DevCh INTEGER NOT NULL, CompTag TEXT NOT NULL, "
+                 "F DOUBLE NOT NULL, I DOUBLE, Field DOUBLE, Err DOUBLE, "
+                 "PRIMARY KEY(LineId, SiteId, DevId, DevCh, F, CompTag)) WITHOUT ROWID"
+              <<"INSERT OR REPLACE INTO RX_New SELECT LineId, SiteId, DevId, DevCh, IFNULL(CompTag, ''), "
+                "F, I, Field, Err FROM RX WHERE LineId NOT NULL AND SiteId NOT NULL AND "
+                "DevId NOT NULL AND DevCh NOT NULL AND F NOT NULL"
+             <<"DROP TABLE RX"
+            <<"ALTER TABLE RX_New RENAME TO RX";
+
+        aoStrSql<<"CREATE TABLE IF NOT EXISTS Coordinate(LineId TEXT, SiteId TEXT, "
+                  "MX TEXT, MY TEXT, MH TEXT, NX TEXT, NY TEXT, NH TEXT)"
+               <<"CREATE TABLE Coordinate_New(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                 "MX TEXT, MY TEXT, MH TEXT, NX TEXT, NY TEXT, NH TEXT, "
+                 "PRIMARY KEY(LineId, SiteId)) WITHOUT ROWID"
+              <<"INSERT OR REPLACE INTO Coordinate_New SELECT LineId, SiteId, MX, MY, MH, NX, NY, NH "
+                "FROM Coordinate WHERE LineId NOT NULL AND SiteId NOT NULL"
+             <<"DROP TABLE Coordinate"
+            <<"ALTER TABLE Coordinate_New RENAME TO Coordinate";
+
+        aoStrSql<<"CREATE TABLE IF NOT EXISTS Rho(LineId TEXT, SiteId TEXT, DevId INTEGER, DevCh INTEGER, "
+                  "CompTag TEXT, F DOUBLE, I DOUBLE, Field DOUBLE, Err TEXT, Rho DOUBLE, "
+                  "AX TEXT, AY TEXT, AH TEXT, BX TEXT, BY TEXT, BH TEXT, "
+                  "MX TEXT, MY TEXT, MH TEXT, NX TEXT, NY TEXT, NH TEXT)"
+               <<"CREATE TABLE Rho_New(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                 "DevId INTEGER NOT NULL, DevCh INTEGER NOT NULL, CompTag TEXT NOT NULL, "
+                 "F DOUBLE NOT NULL, I DOUBLE, Field DOUBLE, Err TEXT, Rho DOUBLE, "
+                 "AX TEXT, AY TEXT, AH TEXT, BX TEXT, BY TEXT, BH TEXT, "
+                 "MX TEXT, MY TEXT, MH TEXT, NX TEXT, NY TEXT, NH TEXT, "
+                 "PRIMARY KEY(LineId, SiteId, DevId, DevCh, F, CompTag)) WITHOUT ROWID"
+              <<"INSERT OR REPLACE INTO Rho_New SELECT LineId, SiteId, DevId, DevCh, IFNULL(CompTag, ''), "
+                "F, I, Field, Err, Rho, AX, AY, AH, BX, BY, BH, MX, MY, MH, NX, NY, NH FROM Rho "
+                "WHERE LineId NOT NULL AND SiteId NOT NULL AND DevId NOT NULL AND DevCh NOT NULL AND F NOT NULL"
+             <<"DROP TABLE Rho"
+            <<"ALTER TABLE Rho_New RENAME TO Rho";
+        break;
+    case 2:
+        /* 版本2：坐标，以及Rho的场值、误差、视电阻率和坐标原来是格式化后的文本，
+         * 改为REAL全精度保存，误差去掉%。显示格式见CustomTableModel::setColumnFormat */
+        aoStrSql<<"CREATE TABLE Coordinate_New(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                  "MX REAL, MY REAL, MH REAL, NX REAL, NY REAL, NH REAL, "
+                  "PRIMARY KEY(LineId, SiteId)) WITHOUT ROWID"
+               <<"INSERT INTO Coordinate_New SELECT LineId, SiteId, "
+                 "CAST(MX AS REAL), CAST(MY AS REAL), CAST(MH AS REAL), "
+                 "CAST(NX AS REAL), CAST(NY AS REAL), CAST(NH AS REAL) FROM Coordinate"
+              <<"DROP TABLE Coordinate"
+             <<"ALTER TABLE Coordinate_New RENAME TO Coordinate";
+
+        aoStrSql<<"CREATE TABLE Rho_New(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                  "DevId INTEGER NOT NULL, DevCh INTEGER NOT NULL, CompTag TEXT NOT NULL, "
+                  "F REAL NOT NULL, I REAL, Field REAL, Err REAL, Rho REAL, "
+                  "AX REAL, AY REAL, AH REAL, BX REAL, BY REAL, BH REAL, "
+                  "MX REAL, MY REAL, MH REAL, NX REAL, NY REAL, NH REAL, "
+                  "PRIMARY KEY(LineId, SiteId, DevId, DevCh, F, CompTag)) WITHOUT ROWID"
+               <<"INSERT INTO Rho_New SELECT LineId, SiteId, DevId, DevCh, CompTag, F, I, "
+                 "CAST(Field AS REAL), CAST(REPLACE(Err, '%', '') AS REAL), CAST(Rho AS REAL), "
+                 "CAST(AX AS REAL), CAST(AY AS REAL), CAST(AH AS REAL), "
+                 "CAST(BX AS REAL), CAST(BY AS REAL), CAST(BH AS REAL), "
+                 "CAST(MX AS REAL), CAST(MY AS REAL), CAST(MH AS REAL), "
+                 "CAST(NX AS REAL), CAST(NY AS REAL), CAST(NH AS REAL) FROM Rho"
+              <<"DROP TABLE Rho"
+             <<"ALTER TABLE Rho_New RENAME TO Rho";
+        break;
+    case 3:
+        /* 版本3：数据库按项目保存，不再启动时清空。记下导入过的源文件，
+         * 重新导入时只处理新增和改过的文件。Kind：TX/RX/XY */
+        aoStrSql<<"CREATE TABLE SourceFile(Path TEXT NOT NULL, Kind TEXT NOT NULL, "
+                  "Size INTEGER, MTime INTEGER, Hash INTEGER, "
+                  "PRIMARY KEY(Path)) WITHOUT ROWID";
+        break;
+    case 4:
+        /* 版本4：一个站点的AB/MN坐标原来在每个频点的行里重复一遍。
+         * 坐标改存在RhoStation中，每个站点一行；RhoData只存各频点的值。
+         * Rho改为把两张表连起来的视图，列与原来的22列相同，表格、导出和按站点的查询都不用改；
+         * 往视图里插入由触发器拆到两张表中，importRho也不用改。 */
+        aoStrSql<<"CREATE TABLE RhoStation(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                  "DevId INTEGER NOT NULL, DevCh INTEGER NOT NULL, CompTag TEXT NOT NULL, "
+                  "AX REAL, AY REAL, AH REAL, BX REAL, BY REAL, BH REAL, "
+                  "MX REAL, MY REAL, MH REAL, NX REAL, NY REAL, NH REAL, "
+                  "PRIMARY KEY(LineId, SiteId, DevId, DevCh, CompTag)) WITHOUT ROWID"
+               <<"CREATE TABLE RhoData(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                 "DevId INTEGER NOT NULL, DevCh INTEGER NOT NULL, CompTag TEXT NOT NULL, "
+                 "F REAL NOT NULL, I REAL, Field REAL, Err REAL, Rho REAL, "
+                 "PRIMARY KEY(LineId, SiteId, DevId, DevCh, F, CompTag)) WITHOUT ROWID"
+              <<"INSERT INTO RhoStation SELECT LineId, SiteId, DevId, DevCh, CompTag, "
+                "AX, AY, AH, BX, BY, BH, MX, MY, MH, NX, NY, NH FROM Rho "
+                "GROUP BY LineId, SiteId, DevId, DevCh, CompTag"
+             <<"INSERT INTO RhoData SELECT LineId, SiteId, DevId, DevCh, CompTag, "
+               "F, I, Field, Err, Rho FROM Rho"
+            <<"DROP TABLE Rho";
+
+        aoStrSql<<"CREATE VIEW Rho AS SELECT d.LineId, d.SiteId, d.DevId, d.DevCh, d.CompTag, "
+                  "d.F, d.I, d.Field, d.Err, d.Rho, "
+                  "s.AX, s.AY, s.AH, s.BX, s.BY, s.BH, s.MX, s.MY, s.MH, s.NX, s.NY, s.NH "
+                  "FROM RhoData d JOIN RhoStation s ON s.LineId = d.LineId AND s.SiteId = d.SiteId AND "
+                  "s.DevId = d.DevId AND s.DevCh = d.DevCh AND s.CompTag = d.CompTag"
+               <<"CREATE TRIGGER RhoInsert INSTEAD OF INSERT ON Rho BEGIN "
+                 "INSERT OR REPLACE INTO RhoStation VALUES(NEW.LineId, NEW.SiteId, NEW.DevId, NEW.DevCh, NEW.CompTag, "
+                 "NEW.AX, NEW.AY, NEW.AH, NEW.BX, NEW.BY, NEW.BH, "
+                 "NEW.MX, NEW.MY, NEW.MH, NEW.NX, NEW.NY, NEW.NH); "
+                 "INSERT OR REPLACE INTO RhoData VALUES(NEW.LineId, NEW.SiteId, NEW.DevId, NEW.DevCh, NEW.CompTag, "
+                 "NEW.F, NEW.I, NEW.Field, NEW.Err, NEW.Rho); "
+                 "END";
+        break;
+    case 5:
+        /* 版本5：RhoData加上反演诊断(正演次数、相对残差%、是否收敛)，
+         * 视图和触发器随之重建，新列接在原22列之后，已有数据这三列为NULL */
+        aoStrSql<<"ALTER TABLE RhoData ADD COLUMN Iter INTEGER"
+               <<"ALTER TABLE RhoData ADD COLUMN Residual REAL"
+              <<"ALTER TABLE RhoData ADD COLUMN Converged INTEGER"
+             <<"DROP VIEW Rho";
+
+        aoStrSql<<"CREATE VIEW Rho AS SELECT d.LineId, d.SiteId, d.DevId, d.DevCh, d.CompTag, "
+                  "d.F, d.I, d.Field, d.Err, d.Rho, "
+                  "s.AX, s.AY, s.AH, s.BX, s.BY, s.BH, s.MX, s.MY, s.MH, s.NX, s.NY, s.NH, "
+                  "d.Iter, d.Residual, d.Converged "
+                  "FROM RhoData d JOIN RhoStation s ON s.LineId = d.LineId AND s.SiteId = d.SiteId AND "
+                  "s.DevId = d.DevId AND s.DevCh = d.DevCh AND s.CompTag = d.CompTag"
+               <<"CREATE TRIGGER RhoInsert INSTEAD OF INSERT ON Rho BEGIN "
+                 "INSERT OR REPLACE INTO RhoStation VALUES(NEW.LineId, NEW.SiteId, NEW.DevId, NEW.DevCh, NEW.CompTag, "
+                 "NEW.AX, NEW.AY, NEW.AH, NEW.BX, NEW.BY, NEW.BH, "
+                 "NEW.MX, NEW.MY, NEW.MH, NEW.NX, NEW.NY, NEW.NH); "
+                 "INSERT OR REPLACE INTO RhoData VALUES(NEW.LineId, NEW.SiteId, NEW.DevId, NEW.DevCh, NEW.CompTag, "
+                 "NEW.F, NEW.I, NEW.Field, NEW.Err, NEW.Rho, NEW.Iter, NEW.Residual, NEW.Converged); "
+                 "END";
+        break;
+    default:
+        break;
+    }
+
+    return aoStrSql;
+}
+
+bool MyDatabase::migrate(QSqlDatabase &oDb)
+{
+    QSqlQuery oQuery(oDb);
+
+    if(!oQuery.exec("CREATE TABLE IF NOT EXISTS SchemaVersion(Version INTEGER NOT NULL)"))
     {
         qDebugV5()<<oQuery.lastError().text();
+        return false;
+    }
+
+    int iVersion = 0;
+
+    if(oQuery.exec("SELECT MAX(Version) FROM SchemaVersion") && oQuery.first())
+    {
+        iVersion = oQuery.value(0).toInt();
+    }
+
+    /* 读完就释放，否则后面DROP TABLE时表仍被锁住 */
+    oQuery.finish();
+
+    while(iVersion < DB_SCHEMA_VERSION)
+    {
+        iVersion++;
+
+        oDb.transaction();
+
+        bool bOk = true;
+
+        foreach(QString oStrSql, migration(iVersion))
+        {
+            if(!oQuery.exec(oStrSql))
+            {
+                qDebugV5()<<oStrSql<<oQuery.lastError().text();
+
+                bOk = false;
+                break;
+            }
+        }
+
+        if(bOk && !oQuery.exec(QString("INSERT INTO SchemaVersion VALUES(%1)").arg(iVersion)))
+        {
+            qDebugV5()<<oQuery.lastError().text();
+
+            bOk = false;
+        }
+
+        if(!bOk)
+        {
+            oDb.rollback();
+            return false;
+        }
+
+        oDb.commit();
+
+        qDebugV0()<<"DB schema migrated to version"<<iVersion;
+    }
+
+    return true;
+}
+
+/************************************************************************
+ * 批量执行预编译语句：每列一个QVariantList，按"?"的顺序绑定。
+ * SQL只解析一次，数值以double绑定，不经过字符串，不损失精度。
+ */
+bool MyDatabase::execBatch(QSqlQuery &oQuery, QVector<QVariantList> &aaoColumn)
+{
+    if(aaoColumn.isEmpty() || aaoColumn.first().isEmpty())
+    {
+        return true;
     }
-    if(!oQuery.exec("DELETE FROM Rho"))
+
+    for(int i = 0; i < aaoColumn.count(); i++)
+    {
+        oQuery.bindValue(i, aaoColumn.at(i));
+    }
+
+    bool bOk = oQuery.execBatch();
+
+    if(!bOk)
     {
         qDebugV5()<<oQuery.lastError().text();
     }
+
+    for(int i = 0; i < aaoColumn.count(); i++)
+    {
+        aaoColumn[i].clear();
+    }
+
+    return bOk;
 }
 
 /* 导入电流文件 */
@@ -42,7 +765,7 @@ void MyDatabase::importTX(QString oStrFileName)
 {
     QFile oFile(oStrFileName);
 
-    if( !oFile.open( QFile::ReadOnly | QFile::Text ) )
+    if( !oFile.open( QFile::ReadOnly ) )
     {
         QMessageBox::critical(NULL, tr("错误"),
                               QString("打开:\n%1\n失败").arg(oStrFileName),
@@ -50,111 +773,112 @@ void MyDatabase::importTX(QString oStrFileName)
         return;
     }
 
-    QString::SectionFlag flag = QString::SectionSkipEmpty;
+    QByteArray aoData = oFile.readAll();
 
-    QTextStream stream(&oFile);
+    oFile.close();
 
-    QSqlQuery oQuery(*poDb);
-    poDb->transaction();
+    DB_WRITE sWrite;
+
+    sWrite.iModel = DB_MODEL_TX;
+    sWrite.iTables = DB_TABLE_TX;
 
     /* 在写之前，就将原来的数据清除掉。 */
-    if(!oQuery.exec("DELETE FROM TX"))
-    {
-        qDebugV5()<<oQuery.lastError().text();
-    }
+    sWrite.aoStrPre<<"DELETE FROM TX";
 
-    stream.seek(0);
-    while (!stream.atEnd())
-    {
-        QString oStrLine = stream.readLine();
+    /* F, I */
+    sWrite.oStrSql = "INSERT OR REPLACE INTO TX VALUES(?, ?)";
 
-        bool bOkF = false, bOkI = false;
+    QVector<QVariantList> &aaoColumn = sWrite.aaoColumn;
+    aaoColumn.resize(2);
 
-        double dF = oStrLine.section(",",0,0, flag).toDouble(&bOkF);
-        double dI = oStrLine.section(",",1,1, flag).toDouble(&bOkI);
+    CsvReader oReader(aoData.constData(), aoData.constData() + aoData.size());
 
-        if(bOkF && bOkI)
+    QVector<CSV_FIELD> aoField;
+
+    while(oReader.readLine())
+    {
+        if(oReader.isEmptyLine())
         {
-            /* LineID, SiteID, DevID, DevCH, CompTag, F, Amplitude, Phase */
-            if( !oQuery.exec(QString("INSERT INTO TX VALUES(%1, %2)")
-                             .arg(dF)
-                             .arg(dI)))
+            continue;
+        }
 
-            {
-                qDebugV5()<<oQuery.lastError().text();
-            }
+        double dF = 0, dI = 0;
+
+        if(oReader.split(&aoField) < 2 ||
+                !CsvReader::toDouble(aoField.at(0), &dF) ||
+                !CsvReader::toDouble(aoField.at(1), &dI))
+        {
+            /* 表头等非数据行，跳过 */
+            oReader.error("不是\"频率,电流\"格式，此行忽略");
+        }
+        else
+        {
+            aaoColumn[0].append(dF);
+            aaoColumn[1].append(dI);
         }
     }
 
-    poDb->commit();
+    this->submit(sWrite);
+
+    this->recordSource("TX", QList<SOURCE_FILE>()<<sourceOf(oStrFileName, RX::hashBytes(aoData.constData(), aoData.size())), true);
 
-    /* 更新model */
-    QSqlTableModel *poModel = new QSqlTableModel(this, *poDb);
-    poModel->setTable("TX");
-    poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
+    /* 电流表变了，内存中的作废，下次getI等写完再重读 */
+    {
+        QMutexLocker oLocker(&goTxMutex);
+
+        gbTxLoaded = false;
 
-    poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("频率"));
-    poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("电流"));
-    poModel->select();
+        adTxMissing.clear();
+    }
 
-    emit SigModelTX(poModel);
+    foreach(QString oStrErr, oReader.errors())
+    {
+        qDebugV5()<<oStrFileName<<oStrErr;
+    }
 }
 
 /* 将接收端场值写入到数据库中 */
 void MyDatabase::importRX(QVector<RX*> apoRX)
 {
-    QSqlQuery oQuery(*poDb);
-    poDb->transaction();
+    DB_WRITE sWrite;
 
-    if(!oQuery.exec("DELETE FROM RX"))
-    {
-        qDebugV5()<<oQuery.lastError().text();
-    }
+    sWrite.iModel = DB_MODEL_RX;
+    sWrite.iTables = DB_TABLE_RX;
+
+    sWrite.aoStrPre<<"DELETE FROM RX";
+
+    /* LineID, SiteID, DevID, DevCH, CompTag, F, I, Field, Err */
+    sWrite.oStrSql = "INSERT OR REPLACE INTO RX VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+    QVector<QVariantList> &aaoColumn = sWrite.aaoColumn;
+    aaoColumn.resize(9);
 
     foreach(RX *poRX, apoRX)
     {
-        foreach(double dF, poRX->adF)
+        for(int i = 0; i < poRX->adF.count(); i++)
         {
-            /* LineID, SiteID, DevID, DevCH, CompTag, F, Amplitude, Phase */
-            if( !oQuery.exec(QString("INSERT INTO RX VALUES('%1', '%2', %3, %4, '%5', %6, %7, %8, %9)")
-                             .arg(poRX->goStrLineId)
-                             .arg(poRX->goStrSiteId)
-                             .arg(poRX->giDevId)
-                             .arg(poRX->giDevCh)
-                             .arg(poRX->goStrCompTag)
-                             .arg(dF)
-                             .arg(this->getI(dF))
-                             .arg(poRX->mapAvg.value(dF))
-                             .arg(poRX->mapErr.value(dF))))
-            {
-                qDebugV5()<<oQuery.lastError().text();
-            }
+            double dF = poRX->adF.at(i);
+
+            aaoColumn[0].append(poRX->goStrLineId);
+            aaoColumn[1].append(poRX->goStrSiteId);
+            aaoColumn[2].append(poRX->giDevId);
+            aaoColumn[3].append(poRX->giDevCh);
+            aaoColumn[4].append(poRX->goStrCompTag);
+            aaoColumn[5].append(dF);
+            aaoColumn[6].append(this->getI(dF));
+            aaoColumn[7].append(poRX->adAvg.at(i));
+            aaoColumn[8].append(poRX->adErr.at(i));
         }
     }
-    poDb->commit();
 
-    QSqlTableModel *poModel = new QSqlTableModel(this, *poDb);
-    poModel->setTable("RX");
-    poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-    poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("线号"));
-    poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("点号"));
-    poModel->setHeaderData(2, Qt::Horizontal, QStringLiteral("仪器号"));
-    poModel->setHeaderData(3, Qt::Horizontal, QStringLiteral("通道号"));
-    poModel->setHeaderData(4, Qt::Horizontal, QStringLiteral("分量标识"));
-    poModel->setHeaderData(5, Qt::Horizontal, QStringLiteral("频率"));
-    poModel->setHeaderData(6, Qt::Horizontal, QStringLiteral("电流"));
-    poModel->setHeaderData(7, Qt::Horizontal, QStringLiteral("场值"));
-    poModel->setHeaderData(8, Qt::Horizontal, QStringLiteral("相对均方误差"));
-    poModel->select();
-
-    emit SigModelRX(poModel);
+    this->submit(sWrite);
 }
 
 bool MyDatabase::importXY(QString oStrFileName)
 {
     QFile oFile(oStrFileName);
 
-    if( !oFile.open( QFile::ReadOnly | QFile::Text ) )
+    if( !oFile.open( QFile::ReadOnly ) )
     {
         QMessageBox::critical(NULL, tr("错误"),
                               QString("打开:\n%1\n失败").arg(oStrFileName),
@@ -162,186 +886,170 @@ bool MyDatabase::importXY(QString oStrFileName)
         return false;
     }
 
-    QString::SectionFlag flag = QString::SectionSkipEmpty;
-
-    QTextStream stream(&oFile);
+    QByteArray aoData = oFile.readAll();
 
-    QSqlQuery oQuery(*poDb);
+    oFile.close();
 
-    poDb->transaction();
+    CsvReader oReader(aoData.constData(), aoData.constData() + aoData.size());
 
-    if(!oQuery.exec("DELETE FROM Coordinate"))
-    {
-        qDebugV5()<<oQuery.lastError().text();
-    }
+    QVector<CSV_FIELD> aoField;
 
-    if( stream.readLine().split(",").count() != 8)
+    /* 首行就不是8列，整个文件不认 */
+    if( !oReader.readLine() || oReader.split(&aoField, false) != 8)
     {
         emit SigMsg("坐标文件有误，请核实！");
 
         return false;
     }
 
-    stream.seek(0);
+    DB_WRITE sWrite;
 
-    while (!stream.atEnd())
+    sWrite.iModel = DB_MODEL_XY;
+    sWrite.iTables = DB_TABLE_XY;
+
+    sWrite.aoStrPre<<"DELETE FROM Coordinate";
+
+    /* LineId, SiteId, MX, MY, MH, NX, NY, NH */
+    sWrite.oStrSql = "INSERT OR REPLACE INTO Coordinate VALUES(?, ?, ?, ?, ?, ?, ?, ?)";
+
+    QVector<QVariantList> &aaoColumn = sWrite.aaoColumn;
+    aaoColumn.resize(8);
+
+    /* 首行也是数据，从头读 */
+    oReader = CsvReader(aoData.constData(), aoData.constData() + aoData.size());
+
+    while(oReader.readLine())
     {
-        QString oStrLine = stream.readLine();
+        if(oReader.isEmptyLine())
+        {
+            continue;
+        }
 
-        QString oStrLineId = oStrLine.section(",",0,0, flag);
-        QString oStrSiteId = oStrLine.section(",",1,1, flag);
+        /* LineId, SiteId, MX, MY, MH, NX, NY, NH */
+        if(oReader.split(&aoField) != 8)
+        {
+            oReader.error(QString("应为8列，实际%1列，此行忽略").arg(aoField.count()));
+            continue;
+        }
 
-        QString oStrMX = oStrLine.section(",",2,2, flag);
-        QString oStrMY = oStrLine.section(",",3,3, flag);
-        QString oStrMH = oStrLine.section(",",4,4, flag);
+        bool bNumeric = true;
 
-        QString oStrNX = oStrLine.section(",",5,5, flag);
-        QString oStrNY = oStrLine.section(",",6,6, flag);
-        QString oStrNH = oStrLine.section(",",7,7, flag);
+        double adValue[8];
 
-        /* LineId, SiteId, X, Y */
-        if( !oQuery.exec(QString("INSERT INTO Coordinate VALUES('%1', '%2', '%3', '%4', '%5', '%6', '%7', '%8')")
-                         .arg(oStrLineId)
-                         .arg(oStrSiteId)
-                         .arg(oStrMX)
-                         .arg(oStrMY)
-                         .arg(oStrMH)
-                         .arg(oStrNX)
-                         .arg(oStrNY)
-                         .arg(oStrNH)))
+        for(int i = 2; i < 8 && bNumeric; i++)
+        {
+            bNumeric = CsvReader::toDouble(aoField.at(i), &adValue[i]);
+        }
 
+        if(!bNumeric)
         {
-            qDebugV5()<<oQuery.lastError().text();
+            oReader.error("坐标不是数值，此行忽略");
+            continue;
+        }
 
-            return false;
+        aaoColumn[0].append(CsvReader::toString(aoField.at(0)));
+        aaoColumn[1].append(CsvReader::toString(aoField.at(1)));
+
+        for(int i = 2; i < 8; i++)
+        {
+            aaoColumn[i].append(adValue[i]);
         }
     }
 
-    poDb->commit();
+    if(oReader.errorCount() > 0)
+    {
+        emit SigMsg(QString("坐标文件中有%1行格式有误，已忽略：\n%2")
+                    .arg(oReader.errorCount())
+                    .arg(oReader.errors().mid(0, 10).join("\n")));
+    }
 
-    QSqlTableModel *poModel = new QSqlTableModel(this, *poDb);
-    poModel->setTable("Coordinate");
-    poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-    poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("线号"));
-    poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("点号"));
-    poModel->setHeaderData(2, Qt::Horizontal, QStringLiteral("MX"));
-    poModel->setHeaderData(3, Qt::Horizontal, QStringLiteral("MY"));
-    poModel->setHeaderData(4, Qt::Horizontal, QStringLiteral("MH"));
-    poModel->setHeaderData(5, Qt::Horizontal, QStringLiteral("NX"));
-    poModel->setHeaderData(6, Qt::Horizontal, QStringLiteral("NY"));
-    poModel->setHeaderData(7, Qt::Horizontal, QStringLiteral("NH"));
-    poModel->select();
+    /* 写入失败由written提示 */
+    this->submit(sWrite);
 
-    emit SigModelXY(poModel);
+    this->recordSource("XY", QList<SOURCE_FILE>()<<sourceOf(oStrFileName, RX::hashBytes(aoData.constData(), aoData.size())), true);
 
     return true;
 }
 
 void MyDatabase::importRho(QList<RhoResult> aoRhoResult)
 {
-    QSqlQuery oQuery(*poDb);
+    DB_WRITE sWrite;
+
+    /* 计算时一批一批地写，表格不必每批新建 */
+    sWrite.iModel = DB_MODEL_RHO_SELECT;
+    sWrite.iTables = DB_TABLE_RHO;
 
-    poDb->transaction();
+    /* LineID, SiteID, DevID, DevCH, CompTag, F, I, Field, Err, Rho, AB(6), MN(6), Iter, Residual, Converged
+     * 插入的是视图，触发器把坐标写进RhoStation(每站一行)，各频点的值写进RhoData */
+    sWrite.oStrSql = "INSERT OR REPLACE INTO Rho VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+            "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+    QVector<QVariantList> &aaoColumn = sWrite.aaoColumn;
+    aaoColumn.resize(25);
 
     foreach(RhoResult oRhoResult, aoRhoResult)
     {
-        /* LineID, SiteID, DevID, DevCH, CompTag, F, I, Field, Rho */
-        if( !oQuery.exec(QString("INSERT INTO Rho VALUES('%1', '%2', %3, %4, '%5',"
-                                 "%6, %7, '%8', '%9',  '%10', "
-                                 "'%11', '%12', '%13', '%14', '%15', '%16', "
-                                 "'%17', '%18', '%19', '%20', '%21', '%22')")
-                         .arg(oRhoResult.oStation.oStrLineId)
-                         .arg(oRhoResult.oStation.oStrSiteId)
-                         .arg(oRhoResult.oStation.iDevId)
-                         .arg(oRhoResult.oStation.iDevCh)
-                         .arg(oRhoResult.oStation.oStrTag)
-                         .arg(oRhoResult.dF)
-                         .arg(oRhoResult.dI)
-                         .arg(QString::number(oRhoResult.dField, 'f',4))
-                         .arg(QString("%1%").arg(QString::number(oRhoResult.dErr, 'f', 2)))
-                         .arg(QString::number(oRhoResult.dRho, 'f',0))
-                         .arg(QString::number(oRhoResult.oAB.dMX, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oAB.dMY, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oAB.dMZ, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oAB.dNX, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oAB.dNY, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oAB.dNZ, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oMN.dMX, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oMN.dMY, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oMN.dMZ, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oMN.dNX, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oMN.dNY, 10, FloatPrecision))
-                         .arg(QString::number(oRhoResult.oMN.dNZ, 10, FloatPrecision))))
-
+        aaoColumn[0].append(oRhoResult.oStation.oStrLineId);
+        aaoColumn[1].append(oRhoResult.oStation.oStrSiteId);
+        aaoColumn[2].append(oRhoResult.oStation.iDevId);
+        aaoColumn[3].append(oRhoResult.oStation.iDevCh);
+        aaoColumn[4].append(oRhoResult.oStation.oStrTag);
+        aaoColumn[5].append(oRhoResult.dF);
+        aaoColumn[6].append(oRhoResult.dI);
+
+        /* 全精度保存，显示的位数和误差的%由CustomTableModel处理 */
+        aaoColumn[7].append(oRhoResult.dField);
+        aaoColumn[8].append(oRhoResult.dErr);
+        aaoColumn[9].append(oRhoResult.dRho);
+
+        const double adXY[12] = { oRhoResult.oAB.dMX, oRhoResult.oAB.dMY, oRhoResult.oAB.dMZ,
+                                  oRhoResult.oAB.dNX, oRhoResult.oAB.dNY, oRhoResult.oAB.dNZ,
+                                  oRhoResult.oMN.dMX, oRhoResult.oMN.dMY, oRhoResult.oMN.dMZ,
+                                  oRhoResult.oMN.dNX, oRhoResult.oMN.dNY, oRhoResult.oMN.dNZ };
+
+        for(int i = 0; i < 12; i++)
         {
-            qDebugV5()<<oQuery.lastError().text();
+            aaoColumn[10 + i].append(adXY[i]);
         }
-    }
-
-    poDb->commit();
-
-    CustomTableModel *poModel = new CustomTableModel(this, *poDb);
 
-    poModel->setTable("Rho");
-
-    poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-
-    poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("线号"));
-    poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("点号"));
-    poModel->setHeaderData(2, Qt::Horizontal, QStringLiteral("仪器号"));
-    poModel->setHeaderData(3, Qt::Horizontal, QStringLiteral("通道号"));
-    poModel->setHeaderData(4, Qt::Horizontal, QStringLiteral("分量标识"));
-
-    poModel->setHeaderData(5, Qt::Horizontal, QStringLiteral("频率"));
-    poModel->setHeaderData(6, Qt::Horizontal, QStringLiteral("电流"));
-    poModel->setHeaderData(7, Qt::Horizontal, QStringLiteral("场值"));
-    poModel->setHeaderData(8, Qt::Horizontal, QStringLiteral("相对均方误差"));
-    poModel->setHeaderData(9, Qt::Horizontal, QStringLiteral("视电阻率"));
-
-    poModel->setHeaderData(10, Qt::Horizontal, QStringLiteral("AX"));
-    poModel->setHeaderData(11, Qt::Horizontal, QStringLiteral("AY"));
-    poModel->setHeaderData(12, Qt::Horizontal, QStringLiteral("AH"));
-    poModel->setHeaderData(13, Qt::Horizontal, QStringLiteral("BX"));
-    poModel->setHeaderData(14, Qt::Horizontal, QStringLiteral("BY"));
-    poModel->setHeaderData(15, Qt::Horizontal, QStringLiteral("BH"));
-    poModel->setHeaderData(16, Qt::Horizontal, QStringLiteral("MX"));
-    poModel->setHeaderData(17, Qt::Horizontal, QStringLiteral("MY"));
-    poModel->setHeaderData(18, Qt::Horizontal, QStringLiteral("MH"));
-    poModel->setHeaderData(19, Qt::Horizontal, QStringLiteral("NX"));
-    poModel->setHeaderData(20, Qt::Horizontal, QStringLiteral("NY"));
-    poModel->setHeaderData(21, Qt::Horizontal, QStringLiteral("NH"));
-    poModel->select();
+        aaoColumn[22].append(oRhoResult.iIter);
+        aaoColumn[23].append(oRhoResult.dResidual);
+        aaoColumn[24].append(oRhoResult.bConverged ? 1 : 0);
+    }
 
-    emit SigModelRho(poModel);
+    this->submit(sWrite);
 }
 
 void MyDatabase::cleanRho()
 {
-    QSqlQuery oQuery(*poDb);
+    DB_WRITE sWrite;
 
-    poDb->transaction();
+    sWrite.iModel = DB_MODEL_NONE;
+    sWrite.iTables = DB_TABLE_RHO;
 
-    if(!oQuery.exec("DELETE FROM Rho"))
-    {
-        qDebugV5()<<oQuery.lastError().text();
-    }
+    sWrite.aoStrPre<<"DELETE FROM RhoData"
+                  <<"DELETE FROM RhoStation";
 
-    poDb->commit();
+    this->submit(sWrite);
 }
 
 QVector<double> MyDatabase::getF(STATION oStation)
 {
+    this->waitWrites(DB_TABLE_RX);
+
     QSqlQuery oQuery(*poDb);
     QVector<double> adF;
     adF.clear();
 
-    if( ! oQuery.exec(QString("SELECT DISTINCT F FROM RX WHERE "
-                              "LineId = '%1' AND SiteId = '%2' AND "
-                              "DevId = %3 AND DevCh = %4")
-                      .arg(oStation.oStrLineId)
-                      .arg(oStation.oStrSiteId)
-                      .arg(oStation.iDevId)
-                      .arg(oStation.iDevCh)) )
+    oQuery.prepare("SELECT DISTINCT F FROM RX WHERE "
+                   "LineId = ? AND SiteId = ? AND DevId = ? AND DevCh = ?");
+
+    oQuery.addBindValue(oStation.oStrLineId);
+    oQuery.addBindValue(oStation.oStrSiteId);
+    oQuery.addBindValue(oStation.iDevId);
+    oQuery.addBindValue(oStation.iDevCh);
+
+    if( ! oQuery.exec() )
     {
         qDebugV5()<<oQuery.lastError().text();
     }
@@ -361,41 +1069,92 @@ QVector<double> MyDatabase::getF(STATION oStation)
 /* 获取对应频点的电流值 */
 double MyDatabase::getI(double dF)
 {
-    QSqlQuery oQuery(*poDb);
+    QMutexLocker oLocker(&goTxMutex);
+
+    if(!gbTxLoaded)
+    {
+        this->loadTX();
+    }
 
     /* Default = 1， 电流要用来做除数，所以不能为0。 2020年03月06日 */
     double dI = 1;
 
-    if( !oQuery.exec(QString("SELECT I FROM TX WHERE F = %1")
-                     .arg(dF)) )
+    /* 容差范围内取最接近的频点 */
+    double dTol = qAbs(dF)*DB_F_TOLERANCE;
+
+    QVector<double>::const_iterator it = std::lower_bound(adTxF.constBegin(), adTxF.constEnd(), dF - dTol);
+
+    int iBest = -1;
+
+    for(; it != adTxF.constEnd() && *it <= dF + dTol; ++it)
     {
-        qDebugV5()<<oQuery.lastError().text();
+        int iIdx = it - adTxF.constBegin();
+
+        if(iBest == -1 || qAbs(*it - dF) < qAbs(adTxF.at(iBest) - dF))
+        {
+            iBest = iIdx;
+        }
     }
-    if(oQuery.first())
+
+    if(iBest != -1)
     {
-        dI = oQuery.value("I").toDouble();
+        dI = adTxI.at(iBest);
     }
-    else
+    else if(!adTxMissing.contains(dF))
     {
+        adTxMissing.insert(dF);
+
+        /* 提示框会跑事件循环，重绘时可能再进getI，先放锁 */
+        oLocker.unlock();
+
         emit SigMsg(QString("未找到频点%1Hz的电流值！\n请确认。").arg(dF));
     }
 
     return dI;
 }
 
+/* TX整表读入内存，按频率升序 */
+void MyDatabase::loadTX()
+{
+    this->waitWrites(DB_TABLE_TX);
+
+    adTxF.clear();
+    adTxI.clear();
+
+    QSqlQuery oQuery(*poDb);
+
+    if(!oQuery.exec("SELECT F, I FROM TX ORDER BY F"))
+    {
+        qDebugV5()<<oQuery.lastError().text();
+    }
+
+    while(oQuery.next())
+    {
+        adTxF.append(oQuery.value(0).toDouble());
+        adTxI.append(oQuery.value(1).toDouble());
+    }
+
+    gbTxLoaded = true;
+}
+
 double MyDatabase::getField(STATION oStation, double dF)
 {
+    this->waitWrites(DB_TABLE_RX);
+
     QSqlQuery oQuery(*poDb);
     double dField = 0;
 
-    if( ! oQuery.exec(QString("SELECT Field FROM RX WHERE "
-                              "LineId = '%1' AND SiteId = '%2' AND "
-                              "DevId  =  %3  AND DevCh  = %4   AND F = %5")
-                      .arg(oStation.oStrLineId)
-                      .arg(oStation.oStrSiteId)
-                      .arg(oStation.iDevId)
-                      .arg(oStation.iDevCh)
-                      .arg(dF)) )
+    /* F按double绑定：导入时按全精度存储，拼成字符串只有6位有效数字会查不到 */
+    oQuery.prepare("SELECT Field FROM RX WHERE "
+                   "LineId = ? AND SiteId = ? AND DevId = ? AND DevCh = ? AND F = ?");
+
+    oQuery.addBindValue(oStation.oStrLineId);
+    oQuery.addBindValue(oStation.oStrSiteId);
+    oQuery.addBindValue(oStation.iDevId);
+    oQuery.addBindValue(oStation.iDevCh);
+    oQuery.addBindValue(dF);
+
+    if( ! oQuery.exec() )
     {
         qDebugV5()<<oQuery.lastError().text();
     }
@@ -416,17 +1175,22 @@ double MyDatabase::getField(STATION oStation, double dF)
 
 double MyDatabase::getErr(STATION oStation, double dF)
 {
+    this->waitWrites(DB_TABLE_RX);
+
     QSqlQuery oQuery(*poDb);
     double dErr = 0;
 
-    if( ! oQuery.exec(QString("SELECT Err FROM RX WHERE "
-                              "LineId = '%1' AND SiteId = '%2' AND "
-                              "DevId  =  %3  AND DevCh  = %4   AND F = %5")
-                      .arg(oStation.oStrLineId)
-                      .arg(oStation.oStrSiteId)
-                      .arg(oStation.iDevId)
-                      .arg(oStation.iDevCh)
-                      .arg(dF)) )
+    /* F按double绑定：导入时按全精度存储，拼成字符串只有6位有效数字会查不到 */
+    oQuery.prepare("SELECT Err FROM RX WHERE "
+                   "LineId = ? AND SiteId = ? AND DevId = ? AND DevCh = ? AND F = ?");
+
+    oQuery.addBindValue(oStation.oStrLineId);
+    oQuery.addBindValue(oStation.oStrSiteId);
+    oQuery.addBindValue(oStation.iDevId);
+    oQuery.addBindValue(oStation.iDevCh);
+    oQuery.addBindValue(dF);
+
+    if( ! oQuery.exec() )
     {
         qDebugV5()<<oQuery.lastError().text();
     }
@@ -445,8 +1209,61 @@ double MyDatabase::getErr(STATION oStation, double dF)
     return dErr;
 }
 
+/************************************************************************
+ * 站点的全部频点：一条按F排序的查询取出场值和误差，电流从内存中的电流表查。
+ * 同一频点有多行(分量不同)时与原getF+getField一样取第一行。
+ */
+SPECTRUM MyDatabase::getSpectrum(STATION oStation)
+{
+    this->waitWrites(DB_TABLE_RX);
+
+    SPECTRUM sSpectrum;
+
+    QSqlQuery oQuery(*poDb);
+
+    oQuery.prepare("SELECT F, Field, Err FROM RX WHERE "
+                   "LineId = ? AND SiteId = ? AND DevId = ? AND DevCh = ? ORDER BY F");
+
+    oQuery.addBindValue(oStation.oStrLineId);
+    oQuery.addBindValue(oStation.oStrSiteId);
+    oQuery.addBindValue(oStation.iDevId);
+    oQuery.addBindValue(oStation.iDevCh);
+
+    if(!oQuery.exec())
+    {
+        qDebugV5()<<oQuery.lastError().text();
+    }
+
+    while(oQuery.next())
+    {
+        double dF = oQuery.value(0).toDouble();
+
+        if(!sSpectrum.adF.isEmpty() && sSpectrum.adF.last() == dF)
+        {
+            continue;
+        }
+
+        sSpectrum.adF.append(dF);
+        sSpectrum.adField.append(oQuery.value(1).toDouble());
+        sSpectrum.adErr.append(oQuery.value(2).toDouble());
+    }
+
+    oQuery.finish();
+
+    sSpectrum.adI.reserve(sSpectrum.adF.count());
+
+    foreach(double dF, sSpectrum.adF)
+    {
+        sSpectrum.adI.append(this->getI(dF));
+    }
+
+    return sSpectrum;
+}
+
 Position MyDatabase::getCoordinate(QString oStrLineId, QString oStrSiteId)
 {
+    this->waitWrites(DB_TABLE_XY);
+
     QSqlQuery oQuery(*poDb);
 
     Position aoPt;
@@ -459,10 +1276,13 @@ Position MyDatabase::getCoordinate(QString oStrLineId, QString oStrSiteId)
     aoPt.dNY = 0;
     aoPt.dNZ = 0;
 
-    if( ! oQuery.exec(QString("SELECT MX, MY, MH, NX, NY, NH FROM Coordinate WHERE "
-                              "LineId = '%1' AND SiteId = '%2'")
-                      .arg(oStrLineId)
-                      .arg(oStrSiteId)))
+    oQuery.prepare("SELECT MX, MY, MH, NX, NY, NH FROM Coordinate WHERE "
+                   "LineId = ? AND SiteId = ?");
+
+    oQuery.addBindValue(oStrLineId);
+    oQuery.addBindValue(oStrSiteId);
+
+    if( ! oQuery.exec() )
     {
         qDebugV5()<<oQuery.lastError().text();
     }
@@ -480,13 +1300,23 @@ Position MyDatabase::getCoordinate(QString oStrLineId, QString oStrSiteId)
     return aoPt;
 }
 
+/************************************************************************
+ * 表中的全部站点(线号/点号/仪器号/通道号)，每个站点一个。
+ * 按主键前缀分组，只走一遍索引；线号点号按数值排序(数值相同再按文本)，结果顺序固定。
+ * 同一站点有多个分量时取分量标识最小的一个。
+ */
 QList<STATION> MyDatabase::getStation(QString oStrTableName)
 {
+    this->waitWrites(tableOf(oStrTableName));
+
     QList< STATION > aoStation;
 
     QSqlQuery oQuery(*poDb);
 
-    if( !oQuery.exec(QString("SELECT LineId, SiteId, DevId, DevCh, CompTag FROM '%1'").arg(oStrTableName)) )
+    if( !oQuery.exec(QString("SELECT LineId, SiteId, DevId, DevCh, MIN(CompTag) AS CompTag FROM '%1' "
+                             "GROUP BY LineId, SiteId, DevId, DevCh "
+                             "ORDER BY CAST(LineId AS REAL), LineId, CAST(SiteId AS REAL), SiteId, DevId, DevCh")
+                     .arg(oStrTableName)) )
     {
         qDebugV5()<<oQuery.lastError().text();
     }
@@ -494,37 +1324,17 @@ QList<STATION> MyDatabase::getStation(QString oStrTableName)
     {
         STATION oStation;
 
-        oStation.oStrLineId = oQuery.value("LineId").toString();
-        oStation.oStrSiteId = oQuery.value("SiteId").toString();
-        oStation.iDevId     = oQuery.value("DevId").toInt();
-        oStation.iDevCh     = oQuery.value("DevCh").toInt();
-        oStation.oStrTag    = oQuery.value("CompTag").toString();
+        oStation.oStrLineId = oQuery.value(0).toString();
+        oStation.oStrSiteId = oQuery.value(1).toString();
+        oStation.iDevId     = oQuery.value(2).toInt();
+        oStation.iDevCh     = oQuery.value(3).toInt();
+        oStation.oStrTag    = oQuery.value(4).toString();
 
         aoStation.append( oStation );
     }
 
-    for (int i = 0; i < aoStation.count(); i++)
-    {
-        for (int k = i + 1; k <  aoStation.count(); k++)
-        {
-            if ( aoStation.at(i).oStrLineId == aoStation.at(k).oStrLineId &&
-                 aoStation.at(i).oStrSiteId == aoStation.at(k).oStrSiteId &&
-                 aoStation.at(i).iDevId == aoStation.at(k).iDevId &&
-                 aoStation.at(i).iDevCh == aoStation.at(k).iDevCh)
-            {
-                aoStation.removeAt(k);
-                k--;
-            }
-        }
-    }
+    qDebugV0()<<oStrTableName<<"stations:"<<aoStation.count();
 
-    foreach(STATION oStation, aoStation)
-    {
-        qDebugV0()<<oStation.oStrLineId
-                 <<oStation.oStrSiteId
-                <<oStation.iDevId
-               <<oStation.iDevCh;
-    }
     return aoStation;
 }
 
@@ -536,18 +1346,22 @@ QList<STATION> MyDatabase::getStation(QString oStrTableName)
  */
 double MyDatabase::getRho(STATION oStation, double dF)
 {
+    this->waitWrites(DB_TABLE_RHO);
+
     double dRho = 0;
 
     QSqlQuery oQuery(*poDb);
 
-    if( !oQuery.exec(QString("Select Rho from Rho Where LineId = '%1' and SiteId = '%2' and "
-                             "DevId = %3 and DevCh = %4 and F = %5 ")
-                     .arg(oStation.oStrLineId)
-                     .arg(oStation.oStrSiteId)
-                     .arg(oStation.iDevId)
-                     .arg(oStation.iDevCh)
-                     .arg(dF)))
+    oQuery.prepare("Select Rho from Rho Where LineId = ? and SiteId = ? and "
+                   "DevId = ? and DevCh = ? and F = ?");
 
+    oQuery.addBindValue(oStation.oStrLineId);
+    oQuery.addBindValue(oStation.oStrSiteId);
+    oQuery.addBindValue(oStation.iDevId);
+    oQuery.addBindValue(oStation.iDevCh);
+    oQuery.addBindValue(dF);
+
+    if( !oQuery.exec() )
     {
         qDebugV5()<<oQuery.lastError().text();
     }
@@ -562,6 +1376,8 @@ double MyDatabase::getRho(STATION oStation, double dF)
 /* 从数据库里面读取指定线的广域视电阻率值 */
 QPolygonF MyDatabase::getRho(STATION oStation)
 {
+    this->waitWrites(DB_TABLE_RHO);
+
     QPolygonF aoPointF;
     aoPointF.clear();
 
@@ -569,14 +1385,15 @@ QPolygonF MyDatabase::getRho(STATION oStation)
 
     QSqlQuery oQuery(*poDb);
 
-    if( !oQuery.exec(QString("Select F, Rho From Rho Where "
-                             "LineId = '%1' and SiteId = '%2' and "
-                             "DevId  = %3   and DevCh  = %4")
-                     .arg(oStation.oStrLineId)
-                     .arg(oStation.oStrSiteId)
-                     .arg(oStation.iDevId)
-                     .arg(oStation.iDevCh)))
+    oQuery.prepare("Select F, Rho From Rho Where "
+                   "LineId = ? and SiteId = ? and DevId = ? and DevCh = ?");
+
+    oQuery.addBindValue(oStation.oStrLineId);
+    oQuery.addBindValue(oStation.oStrSiteId);
+    oQuery.addBindValue(oStation.iDevId);
+    oQuery.addBindValue(oStation.iDevCh);
 
+    if( !oQuery.exec() )
     {
         qDebugV5()<<oQuery.lastError().text();
     }
@@ -591,66 +1408,66 @@ QPolygonF MyDatabase::getRho(STATION oStation)
     return aoPointF;
 }
 
-void MyDatabase::modifyRho(STATION oStation, QPolygonF aoPointF)
+/******************************************************************************
+ * 手动修改的视电阻率：全部(站点, 频率, Rho)先批量插入写连接上的临时表，
+ * 再用一条UPDATE按主键改到RhoData表中。整批一个事务，表格model只刷新一次。
+ */
+DB_WRITE MyDatabase::rhoUpdate(QList<STATION> aoStation, QList<QPolygonF> aaoPointF)
 {
-    qDebugV0()<<oStation.oStrLineId<<oStation.oStrSiteId<<oStation.iDevId<<oStation.iDevCh<<aoPointF;
+    DB_WRITE sWrite;
 
-    QSqlQuery oQuery(*poDb);
+    sWrite.iModel = DB_MODEL_RHO_SELECT;
+    sWrite.iTables = DB_TABLE_RHO;
+
+    /* 临时表只在写线程的连接上可见，建一次一直用 */
+    sWrite.aoStrPre<<"CREATE TEMP TABLE IF NOT EXISTS RhoEdit(LineId TEXT NOT NULL, SiteId TEXT NOT NULL, "
+                     "DevId INTEGER NOT NULL, DevCh INTEGER NOT NULL, CompTag TEXT NOT NULL, "
+                     "F REAL NOT NULL, Rho REAL, "
+                     "PRIMARY KEY(LineId, SiteId, DevId, DevCh, F, CompTag)) WITHOUT ROWID"
+                  <<"DELETE FROM RhoEdit";
+
+    /* LineId, SiteId, DevId, DevCh, CompTag, F, Rho */
+    sWrite.oStrSql = "INSERT OR REPLACE INTO RhoEdit VALUES(?, ?, ?, ?, ?, ?, ?)";
 
-    poDb->transaction();
+    QVector<QVariantList> &aaoColumn = sWrite.aaoColumn;
+    aaoColumn.resize(7);
 
-    foreach(QPointF oPoint, aoPointF)
+    for(int i = 0; i < aoStation.count() && i < aaoPointF.count(); i++)
     {
-        /* LineID, SiteID, DevID, DevCH, CompTag, F, I, Field, Rho */
-        if( !oQuery.exec(QString("Update Rho Set Rho = '%1' Where "
-                                 "LineId = '%2' and SiteId = '%3' and "
-                                 "DevId  = %4   and DevCh  = %5   and "
-                                 "F = %6 ")
-                         .arg(QString::number(oPoint.y(),'f',0))
-                         .arg(oStation.oStrLineId)
-                         .arg(oStation.oStrSiteId)
-                         .arg(oStation.iDevId)
-                         .arg(oStation.iDevCh)
-                         .arg(oPoint.x())))
+        const STATION &oStation = aoStation.at(i);
 
+        foreach(QPointF oPoint, aaoPointF.at(i))
         {
-            qDebugV5()<<oQuery.lastError().text();
+            aaoColumn[0].append(oStation.oStrLineId);
+            aaoColumn[1].append(oStation.oStrSiteId);
+            aaoColumn[2].append(oStation.iDevId);
+            aaoColumn[3].append(oStation.iDevCh);
+            aaoColumn[4].append(oStation.oStrTag);
+            aaoColumn[5].append(oPoint.x());
+            aaoColumn[6].append(oPoint.y());
         }
     }
 
-    poDb->commit();
-
-    CustomTableModel *poModel = new CustomTableModel(this, *poDb);
-
-    poModel->setTable("Rho");
+    /* RhoData走一遍，每行按主键到RhoEdit里查；不用UPDATE ... FROM，旧版本SQLite也能执行 */
+    sWrite.aoStrPost<<"UPDATE RhoData SET Rho = (SELECT e.Rho FROM RhoEdit e WHERE "
+                      "e.LineId = RhoData.LineId AND e.SiteId = RhoData.SiteId AND e.DevId = RhoData.DevId AND "
+                      "e.DevCh = RhoData.DevCh AND e.F = RhoData.F AND e.CompTag = RhoData.CompTag) "
+                      "WHERE EXISTS (SELECT 1 FROM RhoEdit e WHERE "
+                      "e.LineId = RhoData.LineId AND e.SiteId = RhoData.SiteId AND e.DevId = RhoData.DevId AND "
+                      "e.DevCh = RhoData.DevCh AND e.F = RhoData.F AND e.CompTag = RhoData.CompTag)"
+                   <<"DELETE FROM RhoEdit";
 
-    poModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-
-    poModel->setHeaderData(0, Qt::Horizontal, QStringLiteral("线号"));
-    poModel->setHeaderData(1, Qt::Horizontal, QStringLiteral("点号"));
-    poModel->setHeaderData(2, Qt::Horizontal, QStringLiteral("仪器号"));
-    poModel->setHeaderData(3, Qt::Horizontal, QStringLiteral("通道号"));
-    poModel->setHeaderData(4, Qt::Horizontal, QStringLiteral("分量标识"));
+    return sWrite;
+}
 
-    poModel->setHeaderData(5, Qt::Horizontal, QStringLiteral("频率"));
-    poModel->setHeaderData(6, Qt::Horizontal, QStringLiteral("电流"));
-    poModel->setHeaderData(7, Qt::Horizontal, QStringLiteral("场值"));
-    poModel->setHeaderData(8, Qt::Horizontal, QStringLiteral("相对均方误差"));
-    poModel->setHeaderData(9, Qt::Horizontal, QStringLiteral("视电阻率"));
+void MyDatabase::modifyRho(QList<STATION> aoStation, QList<QPolygonF> aaoPointF)
+{
+    qDebugV0()<<"Modify Rho, curves:"<<aoStation.count();
 
-    poModel->setHeaderData(10, Qt::Horizontal, QStringLiteral("AX"));
-    poModel->setHeaderData(11, Qt::Horizontal, QStringLiteral("AY"));
-    poModel->setHeaderData(12, Qt::Horizontal, QStringLiteral("AH"));
-    poModel->setHeaderData(13, Qt::Horizontal, QStringLiteral("BX"));
-    poModel->setHeaderData(14, Qt::Horizontal, QStringLiteral("BY"));
-    poModel->setHeaderData(15, Qt::Horizontal, QStringLiteral("BH"));
-    poModel->setHeaderData(16, Qt::Horizontal, QStringLiteral("MX"));
-    poModel->setHeaderData(17, Qt::Horizontal, QStringLiteral("MY"));
-    poModel->setHeaderData(18, Qt::Horizontal, QStringLiteral("MH"));
-    poModel->setHeaderData(19, Qt::Horizontal, QStringLiteral("NX"));
-    poModel->setHeaderData(20, Qt::Horizontal, QStringLiteral("NY"));
-    poModel->setHeaderData(21, Qt::Horizontal, QStringLiteral("NH"));
-    poModel->select();
+    if(aoStation.isEmpty())
+    {
+        return;
+    }
 
-    emit SigModelRho(poModel);
+    this->submit(rhoUpdate(aoStation, aaoPointF));
 }
@@ -4,6 +4,8 @@
 #include <QObject>
 
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QDateTime>
 #include <QMessageBox>
 
 #include <QSqlDatabase>
@@ -14,12 +16,44 @@
 
 #include <QSqlTableModel>
 
+#include <QMutex>
+
+#include <QThread>
+
 
 #include "Data/RX.h"
+#include "Common/CsvReader.h"
 
 
 #include "CustomTableModel.h"
 
+#include "DbWriter.h"
+
+/* 数据库结构版本，改表结构时加一步迁移(MyDatabase::migration)并加一 */
+#define DB_SCHEMA_VERSION   5
+
+/* 没有打开过其他项目时用的项目数据库 */
+#define DB_DEFAULT_FILE     "MyDb.db"
+
+/* 源文件与项目中记录的比较结果，见MyDatabase::sourceState */
+#define SOURCE_NEW      0
+#define SOURCE_SAME     1
+#define SOURCE_CHANGED  2
+#define SOURCE_MISSING  3
+
+/* 发射电流按频率匹配的相对容差：收发两端的文件可能把同一频率写成不同位数 */
+#define DB_F_TOLERANCE      1e-4
+
+/* 写线程连接的默认同步级别和页缓存(KB)，可用MyDatabase::tune调整 */
+#define DB_SYNCHRONOUS      "NORMAL"
+#define DB_CACHE_KB         16384
+
+/* 写线程批量插入时每DB_BATCH_ROWS行执行一次execBatch(见DbWriter::execute)，限制一次绑定的值占用的内存 */
+#define DB_BATCH_ROWS   5000
+
+/* 广域视电阻率结果文件的列数，即Rho表的前22列；后面的反演诊断列只在表格中显示，不导出 */
+#define DB_RHO_FILE_COLUMNS 22
+
 typedef struct _STATION
 {
     QString oStrLineId;
@@ -31,6 +65,26 @@ typedef struct _STATION
     QString oStrTag;
 }STATION;
 
+/* 一个站点的全部频点，按频率升序，各数组一一对应 */
+typedef struct _SPECTRUM
+{
+    QVector<double> adF;
+    QVector<double> adI;
+    QVector<double> adField;
+    QVector<double> adErr;
+}SPECTRUM;
+
+/* 导入过的源文件：路径(绝对路径)、大小、修改时间(ms)和内容hash */
+typedef struct _SOURCE_FILE
+{
+    QString oStrPath;
+
+    qint64 iSize;
+    qint64 iMTime;
+
+    quint64 ulHash;
+}SOURCE_FILE;
+
 /* Rho result struct */
 typedef struct _RhoResult
 {
@@ -42,6 +96,14 @@ typedef struct _RhoResult
     double dErr;
     double dRho;
 
+    /* 反演诊断：正演次数、相对残差(%)、是否收敛 */
+    int iIter;
+    double dResidual;
+    bool bConverged;
+
+    /* 这一频点调用核函数的次数，不入库 */
+    int iKernel;
+
     Position oAB;
     Position oMN;
 }RhoResult;
@@ -53,7 +115,42 @@ class MyDatabase : public QObject
 public:
     explicit MyDatabase(QObject *parent = 0);
 
-    void connect();
+    ~MyDatabase();
+
+    /* 打开项目数据库(不存在时新建)，保留其中的数据；已打开别的项目时先把它关掉。
+     * 之后的写操作都在写线程中排队执行 */
+    void connect(QString oStrDbFile = DB_DEFAULT_FILE);
+
+    /* 当前项目数据库文件 */
+    QString project();
+
+    /* 把项目中的各表发给界面 */
+    void restore();
+
+    /* 清空项目：各表和源文件记录 */
+    void clearProject();
+
+    /* 记下导入的源文件，bReplace时先清掉同类(oStrKind：TX/RX/XY)的旧记录 */
+    void recordSource(QString oStrKind, QList<SOURCE_FILE> aoSource, bool bReplace = false);
+
+    /* 项目中记录的某类源文件 */
+    QStringList getSource(QString oStrKind);
+
+    /* 文件与项目中的记录比较：SOURCE_NEW/SAME/CHANGED/MISSING */
+    int sourceState(QString oStrFile);
+
+    /* 文件当前的大小、修改时间和内容hash，ulHash非0时直接用(如RX::gulCsvHash)，不再读文件 */
+    static SOURCE_FILE sourceOf(QString oStrFile, quint64 ulHash = 0);
+
+    /* 写线程的同步级别(OFF/NORMAL/FULL)和页缓存(KB) */
+    void tune(QString oStrSynchronous, int iCacheKB);
+
+    /* 等已提交的、改过iTables(DB_TABLE_*的组合)中任一张表的写操作完成；
+     * 读函数开头按自己读的表调用，其它表的写操作不必等，照常读WAL中已提交的快照 */
+    void waitWrites(int iTables = DB_TABLE_ALL);
+
+    /* 表名对应的DB_TABLE_* */
+    static int tableOf(QString oStrTableName);
 
     /* 将发射端电流值写入到数据库中 */
     void importTX(QString oStrFileName);
@@ -71,12 +168,16 @@ public:
 
     QVector<double> getF(STATION oStation);
 
+    /* 对应频点的电流值，从内存中的电流表查，找不到时为1 */
     double getI(double dF);
 
     double getField(STATION oStation, double dF);
 
     double getErr(STATION oStation, double dF);
 
+    /* 一次取出站点的全部频点、电流、场值和误差，代替逐频点的getF/getI/getField/getErr */
+    SPECTRUM getSpectrum(STATION oStation);
+
     Position getCoordinate(QString oStrLineId, QString oStrSiteId);
 
     QList<STATION> getStation(QString oStrTableName);
@@ -87,14 +188,69 @@ public:
     /* 从数据库里面读取指定线的广域视电阻率值 */
     QPolygonF getRho(STATION oStation);
 
-    /* 人为拖动Rho曲线上的点，将呈现的值写进数据库中。*/
-    void modifyRho(STATION oStation, QPolygonF aoPointF);
+    /* 人为拖动Rho曲线上的点，将呈现的值写进数据库中。
+     * aaoPointF[i]是站点aoStation[i]的曲线(x:频率, y:Rho)，所有曲线一批写完 */
+    void modifyRho(QList<STATION> aoStation, QList<QPolygonF> aaoPointF);
+
+    /* modifyRho提交的写操作：暂存到临时表RhoEdit，再一条UPDATE按主键改RhoData表 */
+    static DB_WRITE rhoUpdate(QList<STATION> aoStation, QList<QPolygonF> aaoPointF);
 
     QSqlDatabase *poDb;
 
+    /* 按列绑定到预编译的oQuery上批量执行，执行后清空各列(保留列数)，失败返回false */
+    static bool execBatch(QSqlQuery &oQuery, QVector<QVariantList> &aaoColumn);
+
+    /* 把oDb的表结构逐步升级到DB_SCHEMA_VERSION，版本记在SchemaVersion表中；
+     * 每一步在一个事务中完成，失败时回滚并返回false */
+    static bool migrate(QSqlDatabase &oDb);
+
+private:
+    QThread *poWriterThread;
+
+    DbWriter *poWriter;
+
+    /* 最近一次提交的写操作编号 */
+    qint64 giTicket;
+
+    /* 各表最近一次写操作的编号，下标为DB_TABLE_*的位序 */
+    qint64 aiTableTicket[DB_TABLE_COUNT];
+
+    /* CalRhoThread的工作线程经getI也会等写操作 */
+    QMutex goTicketMutex;
+
+    /* 交给写线程排队执行，按sWrite.iTables记下各表的编号，返回编号 */
+    qint64 submit(DB_WRITE sWrite);
+
+    /* 等写完后停掉写线程 */
+    void closeWriter();
+
+    void emitModel(int iModel);
+
+    /* 最近一次发给界面的Rho model，改了Rho值后重新select它 */
+    CustomTableModel *poRhoModel;
+
+    /* 电流表：TX整表读入，按频率升序；importTX后作废，下次getI时重读 */
+    QVector<double> adTxF, adTxI;
+
+    bool gbTxLoaded;
+
+    /* 已提示过找不到电流的频点，同一频点只提示一次 */
+    QSet<double> adTxMissing;
+
+    /* CalRhoThread在另一线程中调用getI */
+    QMutex goTxMutex;
+
+    void loadTX();
+
+    /* 从iVersion - 1升到iVersion的SQL */
+    static QStringList migration(int iVersion);
+
 signals:    
     void SigMsg(QString);
 
+    /* 交给写线程 */
+    void SigWrite(DB_WRITE);
+
     void SigModelTX(QSqlTableModel *);
 
     void SigModelRX(QSqlTableModel *);
@@ -104,6 +260,8 @@ signals:
     void SigModelRho(CustomTableModel *);
 
 public slots:
+    /* 写线程执行完一批 */
+    void written(qint64 iTicket, int iModel, bool bOk, QString oStrErr);
 
 };
 
@@ -1,9 +1,20 @@
 #include "mainwindow.h"
 #include <QApplication>
 
+#include "Common/Benchmark.h"
+
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    /* 性能测试：DataPreprocess --bench <数据目录> */
+    QStringList aoStrArg = a.arguments();
+    int iBench = aoStrArg.indexOf("--bench");
+    if(iBench != -1 && iBench + 1 < aoStrArg.count())
+    {
+        return Benchmark::run(aoStrArg.at(iBench + 1));
+    }
+
     MainWindow w;
     w.show();
 
@@ -68,7 +68,9 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    this->setWindowTitle("广域数据预处理工具 v2.2 (Design for Engineer Ma)");
+    goStrTitle = "广域数据预处理工具 v2.2 (Design for Engineer Ma)";
+
+    this->setWindowTitle(goStrTitle);
 
     qRegisterMetaType<STATION_INFO>("STATION_INFO");
     qRegisterMetaType< QVector<qreal> >("QVector<qreal>");
@@ -135,8 +137,8 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->actionCalRho->setEnabled(false);
     ui->actionExportRho->setEnabled(false);
 
+    /* 数据库在构造函数最后打开项目时连接 */
     poDb = new MyDatabase();
-    poDb->connect();
 
     connect(poDb, SIGNAL(SigModelTX(QSqlTableModel*)), this, SLOT(showTableTX(QSqlTableModel*)));
     connect(poDb, SIGNAL(SigModelRX(QSqlTableModel*)), this, SLOT(showTableRX(QSqlTableModel*)));
@@ -180,9 +182,19 @@ MainWindow::MainWindow(QWidget *parent) :
     this->initPlotRho();
 
     connect(poCalRho, SIGNAL(SigRho(STATION, QVector<double>, QVector<double>)), this, SLOT(drawRho(STATION, QVector<double>, QVector<double>)));
+    connect(poCalRho, SIGNAL(SigProgress(int,int,double)), this, SLOT(rhoProgress(int,int,double)));
+    connect(poCalRho, SIGNAL(SigFinished(int,int,double)), this, SLOT(rhoFinished(int,int,double)));
+
+    gpoRhoProgress = NULL;
 
     aoStrExisting.clear();
 
+    gpoWatchTimer = new QTimer(this);
+    connect(gpoWatchTimer, SIGNAL(timeout()), this, SLOT(watchRX()));
+
+    giScatterBudgetMB = 64;
+    RX::setScatterBudget(giScatterBudgetMB);
+
     bModifyField = false;
     bModifyRho   = false;
 
@@ -190,10 +202,16 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->splitter->setStretchFactor(1, 1);
     ui->splitter_2->setStretchFactor(0, 5);
     ui->splitter_2->setStretchFactor(1, 1);
+
+    /* 接着上次的项目 */
+    this->openProject(this->LastProjectRead());
 }
 
 MainWindow::~MainWindow()
 {
+    /* 等写线程把排队的写操作做完 */
+    delete poDb;
+
     delete ui;
 }
 
@@ -231,27 +249,228 @@ void MainWindow::on_actionImportRX_triggered()
         return;
     }
 
+    /* 已经导入过的文件不再重复导入，导入后又改过的重新导入 */
+    QStringList aoStrChanged = this->changedRX(aoStrRxThisTime);
+
+    this->dropRX(aoStrChanged);
+
+    QStringList aoStrNew;
+
     foreach(QString oStrRxThisTime, aoStrRxThisTime)
     {
-        if( aoStrExisting.contains(oStrRxThisTime) )
+        if( !aoStrExisting.contains(oStrRxThisTime) && !aoStrNew.contains(oStrRxThisTime) )
         {
-            //qDebugV0()<<"existing~~~"<<oStrRxThisTime;
+            aoStrNew.append(oStrRxThisTime);
+        }
+    }
+
+    QStringList aoStrErr;
+
+    QVector<RX*> apoRX = this->loadRX(aoStrNew, aoStrErr);
+
+    this->appendRX(apoRX, aoStrErr, aoStrRxThisTime.last());
+}
+
+/******************************************************************************
+ * 导入测区目录：递归查找电流文件(FFT_AVG_I_T*.csv)和电场文件(FFT_SEC_V_T*.csv)，
+ * 按内容去重(同一文件拷到不同目录只导入一次)，电场文件一次并行导入。
+ */
+void MainWindow::on_actionImportDir_triggered()
+{
+    QString oStrDir = QFileDialog::getExistingDirectory(this,
+                                                        "打开测区目录",
+                                                        QString("%1").arg(this->LastDirRead()));
+
+    if(oStrDir.isEmpty())
+    {
+        return;
+    }
+
+    QStringList aoStrTX, aoStrRX;
+
+    QDirIterator oIt(oStrDir, QStringList()<<"FFT_SEC_V_T*.csv"<<"FFT_AVG_I_T*.csv",
+                     QDir::Files, QDirIterator::Subdirectories);
+
+    while(oIt.hasNext())
+    {
+        QString oStrFile = oIt.next();
+
+        if(oIt.fileName().startsWith("FFT_AVG_I_T"))
+        {
+            aoStrTX.append(oStrFile);
         }
         else
         {
-            //            qDebugV0()<<"Not existing~~~"<<oStrRxThisTime;
+            aoStrRX.append(oStrFile);
+        }
+    }
+
+    /* 遍历顺序与文件系统有关，排序后结果才稳定 */
+    aoStrTX.sort();
+    aoStrRX.sort();
+
+    QStringList aoStrErr;
+
+    /* 文件名解析不了的，不必读内容 */
+    QStringList aoStrNamed;
+
+    foreach(QString oStrFile, aoStrRX)
+    {
+        QString oStrLineId, oStrSiteId, oStrCompTag;
+        int iDevId = 0, iDevCh = 0;
+
+        if(RX::parseFileName(oStrFile, &oStrLineId, &oStrSiteId, &iDevId, &iDevCh, &oStrCompTag))
+        {
+            aoStrNamed.append(oStrFile);
+        }
+        else
+        {
+            aoStrErr.append(QString("%1：文件名格式有误，无法识别线号/点号/仪器号/通道号/分量").arg(oStrFile));
+        }
+    }
+
+    int iDupCnt = 0;
+
+    aoStrTX = this->uniqueFiles(aoStrTX, QStringList(), &iDupCnt);
+
+    /* 导入后又改过的电场文件重新导入 */
+    this->dropRX(this->changedRX(aoStrNamed));
+
+    QStringList aoStrNew = this->uniqueFiles(aoStrNamed, aoStrExisting, &iDupCnt);
+
+    /* 先导入电流，画曲线时要用它归一化 */
+    if(ui->actionImportTX->isEnabled() && !aoStrTX.isEmpty())
+    {
+        if(aoStrTX.count() > 1)
+        {
+            aoStrErr.append(QString("找到%1个不同的电流文件，只导入了：%2").arg(aoStrTX.count()).arg(aoStrTX.first()));
+        }
+
+        /* 项目里已经是这个电流文件，不必重导 */
+        if(poDb->sourceState(aoStrTX.first()) != SOURCE_SAME)
+        {
+            poDb->importTX(aoStrTX.first());
+        }
+
+        ui->plotTx->setFooter("电流文件："+aoStrTX.first());
+
+        ui->actionImportRX->setEnabled(true);
+    }
+
+    if(!ui->actionImportRX->isEnabled())
+    {
+        QMessageBox::warning(this, "警告", QString("%1\n中没有电流文件，请先导入电流文件！").arg(oStrDir));
+        return;
+    }
+
+    qDebugV0()<<oStrDir<<"TX:"<<aoStrTX.count()<<"RX:"<<aoStrRX.count()
+             <<"new:"<<aoStrNew.count()<<"duplicate:"<<iDupCnt;
+
+    QVector<RX*> apoRX = this->loadRX(aoStrNew, aoStrErr);
+
+    /* LastDirWrite取的是文件所在目录，这里给一个目录下的虚拟文件名 */
+    this->appendRX(apoRX, aoStrErr, QDir(oStrDir).filePath("."));
+}
+
+/******************************************************************************
+ * 按内容去重：先比文件大小，大小相同的才算哈希。
+ * aoStrExist为已导入的文件，与它们内容相同的也去掉。返回保留的文件(顺序不变)，
+ * piDupCnt累加去掉的个数。
+ */
+QStringList MainWindow::uniqueFiles(QStringList aoStrFile, QStringList aoStrExist, int *piDupCnt)
+{
+    QMultiHash<qint64, QString> mapSizeFile;
+
+    foreach(QString oStrFile, aoStrExist + aoStrFile)
+    {
+        mapSizeFile.insert(QFileInfo(oStrFile).size(), oStrFile);
+    }
+
+    QSet<quint64> aulHash;
+
+    /* 已导入的文件先占位 */
+    foreach(QString oStrFile, aoStrExist)
+    {
+        if(mapSizeFile.count(QFileInfo(oStrFile).size()) > 1)
+        {
+            aulHash.insert(RX::hashFile(oStrFile));
+        }
+    }
+
+    QSet<QString> aoStrSeen = aoStrExist.toSet();
+
+    QStringList aoStrUnique;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        if(aoStrSeen.contains(oStrFile))
+        {
+            (*piDupCnt)++;
+            continue;
+        }
+
+        if(mapSizeFile.count(QFileInfo(oStrFile).size()) > 1)
+        {
+            quint64 ulHash = RX::hashFile(oStrFile);
+
+            if(aulHash.contains(ulHash))
+            {
+                qDebugV0()<<"Duplicate content, skipped:"<<oStrFile;
+
+                (*piDupCnt)++;
+                continue;
+            }
 
-            RX *poRX = new RX(oStrRxThisTime);
-            aoStrExisting.append(oStrRxThisTime);
-            gapoRX.append(poRX);
+            aulHash.insert(ulHash);
         }
+
+        aoStrSeen.insert(oStrFile);
+
+        aoStrUnique.append(oStrFile);
+    }
+
+    return aoStrUnique;
+}
+
+/* 新导入的电场文件加入列表并画曲线，记入项目，失败的列在提示框明细里 */
+void MainWindow::appendRX(QVector<RX*> apoRX, QStringList aoStrErr, QString oStrLastFile)
+{
+    QList<SOURCE_FILE> aoSource;
+
+    foreach(RX *poRX, apoRX)
+    {
+        aoStrExisting.append(poRX->oStrCSV);
+        gapoRX.append(poRX);
+
+        connect(poRX, SIGNAL(SigAppended(RX*,QVector<double>)), this, SLOT(extendCurve(RX*,QVector<double>)));
+
+        aoSource.append(MyDatabase::sourceOf(poRX->oStrCSV, poRX->gulCsvHash));
     }
 
-    this->LastDirWrite( aoStrRxThisTime.last() );
+    if(!aoSource.isEmpty())
+    {
+        poDb->recordSource("RX", aoSource);
+    }
+
+    if(!aoStrErr.isEmpty())
+    {
+        QMessageBox oMsgBox(QMessageBox::Warning, "警告",
+                            QString("%1个文件导入失败，详见明细。").arg(aoStrErr.count()),
+                            QMessageBox::Ok, this);
+        oMsgBox.setDetailedText(aoStrErr.join("\n"));
+        oMsgBox.exec();
+    }
+
+    if(gapoRX.isEmpty())
+    {
+        return;
+    }
+
+    this->LastDirWrite( oStrLastFile );
 
     this->drawCurve();
 
-    QFileInfo oFileInfo(aoStrRxThisTime.last());
+    QFileInfo oFileInfo(oStrLastFile);
 
     ui->plotRx->setTitle( "场值文件目录：" + oFileInfo.absolutePath() );
 
@@ -270,12 +489,224 @@ void MainWindow::on_actionImportRX_triggered()
     ui->actionCalRho->setEnabled(true);
 }
 
+/* 已导入的文件中，与项目记录相比内容改过的 */
+QStringList MainWindow::changedRX(QStringList aoStrFile)
+{
+    QStringList aoStrChanged;
+
+    foreach(QString oStrFile, aoStrFile)
+    {
+        if(aoStrExisting.contains(oStrFile) && !aoStrChanged.contains(oStrFile) &&
+                poDb->sourceState(oStrFile) == SOURCE_CHANGED)
+        {
+            aoStrChanged.append(oStrFile);
+        }
+    }
+
+    return aoStrChanged;
+}
+
+/* 去掉这些文件的RX，之后可以当作新文件重新导入 */
+void MainWindow::dropRX(QStringList aoStrFile)
+{
+    if(aoStrFile.isEmpty())
+    {
+        return;
+    }
+
+    qDebugV0()<<"Changed since imported, reload:"<<aoStrFile;
+
+    for(int i = gapoRX.count() - 1; i >= 0; i--)
+    {
+        RX *poRX = gapoRX.at(i);
+
+        if(aoStrFile.contains(poRX->oStrCSV))
+        {
+            aoStrExisting.removeAll(poRX->oStrCSV);
+            gapoRX.remove(i);
+
+            delete poRX;
+        }
+    }
+
+    /* 曲线还指着删掉的RX，重画 */
+    if(gapoRX.isEmpty())
+    {
+        this->clearRX();
+    }
+    else
+    {
+        this->drawCurve();
+    }
+}
+
+/* 线程池中导入单个电场文件 */
+static RX_LOAD loadRXFile(const QString &oStrFileName)
+{
+    RX_LOAD oLoad;
+
+    oLoad.oStrFileName = oStrFileName;
+    oLoad.poRX = new RX(oStrFileName);
+
+    if(!oLoad.poRX->oStrErr.isEmpty())
+    {
+        oLoad.oStrErr = oLoad.poRX->oStrErr;
+
+        delete oLoad.poRX;
+        oLoad.poRX = NULL;
+    }
+    else
+    {
+        /* 在工作线程里创建的，交还给主线程 */
+        oLoad.poRX->moveToThread(QCoreApplication::instance()->thread());
+    }
+
+    return oLoad;
+}
+
+/* 交给QtConcurrent::mapped的导入函数：导入成功的RX同时登记到apoLoaded。
+ * 取消后仍在运行的任务交回的结果会被QFuture丢掉，只能按这张表释放 */
+typedef struct _RX_LOADER
+{
+    typedef RX_LOAD result_type;
+
+    QMutex *poMutex;
+    QList<RX*> *papoLoaded;
+
+    RX_LOAD operator()(const QString &oStrFileName) const
+    {
+        RX_LOAD oLoad = loadRXFile(oStrFileName);
+
+        if(oLoad.poRX != NULL)
+        {
+            QMutexLocker oLocker(poMutex);
+            papoLoaded->append(oLoad.poRX);
+        }
+
+        return oLoad;
+    }
+}RX_LOADER;
+
+/******************************************************************************
+ * 在线程池中并行导入电场文件(线程数 = CPU核数)
+ * 导入过程中显示进度，可以取消；取消时已导入的结果全部丢弃。
+ * 结果按aoStrFile的顺序返回，与各文件完成的先后无关。
+ */
+QVector<RX*> MainWindow::loadRX(QStringList aoStrFile, QStringList &aoStrErr)
+{
+    QVector<RX*> apoRX;
+
+    if(aoStrFile.isEmpty())
+    {
+        return apoRX;
+    }
+
+    QProgressDialog oProgress("正在导入电场文件...", "取消", 0, aoStrFile.count(), this);
+    oProgress.setWindowModality(Qt::WindowModal);
+    oProgress.setMinimumDuration(0);
+
+    QFutureWatcher<RX_LOAD> oWatcher;
+    QEventLoop oLoop;
+
+    connect(&oWatcher, SIGNAL(progressValueChanged(int)), &oProgress, SLOT(setValue(int)));
+    connect(&oProgress, SIGNAL(canceled()), &oWatcher, SLOT(cancel()));
+    connect(&oWatcher, SIGNAL(finished()), &oLoop, SLOT(quit()));
+
+    QMutex oMutex;
+    QList<RX*> apoLoaded;
+
+    RX_LOADER sLoader;
+    sLoader.poMutex = &oMutex;
+    sLoader.papoLoaded = &apoLoaded;
+
+    oWatcher.setFuture(QtConcurrent::mapped(aoStrFile, sLoader));
+
+    /* 界面在等待期间保持响应 */
+    oLoop.exec();
+
+    /* 取消后要等还在运行的任务都结束，apoLoaded才完整 */
+    oWatcher.waitForFinished();
+
+    QFuture<RX_LOAD> oFuture = oWatcher.future();
+
+    if(oFuture.isCanceled())
+    {
+        qDebugV0()<<"Import RX canceled.";
+        qDeleteAll(apoLoaded);
+        return apoRX;
+    }
+
+    for(int i = 0; i < aoStrFile.count(); i++)
+    {
+        RX_LOAD oLoad = oFuture.resultAt(i);
+
+        if(oLoad.poRX == NULL)
+        {
+            aoStrErr.append(QString("%1：%2").arg(oLoad.oStrFileName).arg(oLoad.oStrErr));
+        }
+        else
+        {
+            apoRX.append(oLoad.poRX);
+        }
+    }
+
+    return apoRX;
+}
+
+/* 开关电场文件的二进制缓存 */
+void MainWindow::on_actionCache_toggled(bool bChecked)
+{
+    RX::gbUseCache = bChecked;
+}
+
+/* 散点LRU缓存上限(MB)，所有RX共用，打开再多的接收文件内存也不会超出 */
+void MainWindow::on_actionScatterBudget_triggered()
+{
+    bool bOk = false;
+
+    int iMB = QInputDialog::getInt(this, "散点缓存上限",
+                                   QString("上限(MB)，当前已用 %1 MB：")
+                                   .arg(RX::scatterCacheBytes()/(1024.0*1024.0), 0, 'f', 1),
+                                   giScatterBudgetMB, 1, 4096, 16, &bOk);
+
+    if(bOk)
+    {
+        giScatterBudgetMB = iMB;
+
+        RX::setScatterBudget(iMB);
+    }
+}
+
+/* 开关电场文件的实时监视，每秒检查一次是否有新写入的行 */
+void MainWindow::on_actionWatch_toggled(bool bChecked)
+{
+    if(bChecked)
+    {
+        gpoWatchTimer->start(1000);
+    }
+    else
+    {
+        gpoWatchTimer->stop();
+    }
+}
+
+void MainWindow::watchRX()
+{
+    foreach(RX *poRX, gapoRX)
+    {
+        poRX->tail();
+    }
+}
+
 /* 导出RX平均值供马工使用 */
 void MainWindow::on_actionExportRX_triggered()
 {
     /* Import RX */
     poDb->importRX(gapoRX);
 
+    /* 下面的model直接读RX表，等这次写完 */
+    poDb->waitWrites(DB_TABLE_RX);
+
     QString oStrFileName = QFileDialog::getSaveFileName(this,
                                                         tr("保存当前接收数据"),
                                                         "",
@@ -372,19 +803,7 @@ void MainWindow::on_actionClose_triggered()
             if(oMsgBoxClose.exec() == QMessageBox::Yes)
             {
                 /* 保存Rho曲线上的数据至数据库，以便导出数据库数据到csv文档。再调整广域视电阻率时，何时去点这个保存按钮？*/
-                QMap<QwtPlotCurve*, STATION>::const_iterator it;
-                for(it = gmapCurveStation.constBegin(); it!= gmapCurveStation.constEnd(); it++)
-                {
-                    QPolygonF aoPointF;
-                    aoPointF.clear();
-
-                    for(uint i = 0; i < it.key()->dataSize(); i++)
-                    {
-                        aoPointF.append(it.key()->sample(i));
-                    }
-
-                    poDb->modifyRho(it.value(), aoPointF);
-                }
+                this->storeRho();
             }
         }
 
@@ -400,12 +819,6 @@ void MainWindow::on_actionClear_triggered()
 
     if(oMsgBox.exec() == QMessageBox::Yes)
     {
-        /* 数据都清了,要重新来导入数据了. */
-        if(!ui->actionImportTX->isEnabled())
-        {
-            ui->actionImportTX->setEnabled(true);
-        }
-
         if( bModifyField )
         {
             QMessageBox oMsgBoxStore(QMessageBox::Question, "保存？", "是否保存修改后的\n电位数据？",
@@ -416,91 +829,124 @@ void MainWindow::on_actionClear_triggered()
             }
         }
 
-        ui->stackedWidget->setCurrentIndex(0);
+        this->clearRX();
 
-        QVector<double> xData;
-        xData.clear();
-        QVector<double> yData;
-        yData.clear();
+        this->clearRho();
 
-        gpoScatter->setSamples(xData, yData);
+        /* 数据库按项目保存，不清的话下次打开项目又恢复回来 */
+        poDb->clearProject();
 
-        /* 散点图，褫干净 */
-        ui->plotScatter->replot();
+        qDebugV0()<<"clear~~~";
+    }
+}
+
+/* 清掉全部RX和曲线 */
+void MainWindow::clearRX()
+{
+    /* 数据都清了,要重新来导入数据了. */
+    if(!ui->actionImportTX->isEnabled())
+    {
+        ui->actionImportTX->setEnabled(true);
+    }
 
-        /* 电压除以电流的图，褫干净 */
-        foreach (QwtPlotCurve *poCurve, gmapCurveData.keys())
+    ui->actionImportDir->setEnabled(true);
+
+    ui->stackedWidget->setCurrentIndex(0);
+
+    QVector<double> xData;
+    xData.clear();
+    QVector<double> yData;
+    yData.clear();
+
+    gpoScatter->setSamples(xData, yData);
+
+    /* 散点图，褫干净 */
+    ui->plotScatter->replot();
+
+    /* 电压除以电流的图，褫干净 */
+    foreach (QwtPlotCurve *poCurve, gmapCurveData.keys())
+    {
+        if(poCurve != NULL)
         {
-            if(poCurve != NULL)
-            {
-                poCurve->detach();
-                delete poCurve;
-                poCurve == NULL;
-            }
+            poCurve->detach();
+            delete poCurve;
+            poCurve == NULL;
         }
-        gmapCurveData.clear();
+    }
+    gmapCurveData.clear();
 
-        foreach(RX *oRx, gapoRX)
+    foreach(RX *oRx, gapoRX)
+    {
+        if(oRx != NULL)
         {
-            if(oRx != NULL)
-            {
-                delete oRx;
-                oRx = NULL;
-            }
+            delete oRx;
+            oRx = NULL;
         }
+    }
 
-        gapoRX.clear();
+    gapoRX.clear();
 
-        if(gpoErrorCurve !=NULL)
-        {
-            gpoErrorCurve->detach();
+    if(gpoErrorCurve !=NULL)
+    {
+        gpoErrorCurve->detach();
 
-            delete gpoErrorCurve;
-            gpoErrorCurve = NULL;
-        }
+        delete gpoErrorCurve;
+        gpoErrorCurve = NULL;
+    }
 
-        /* 右手边，tableWidget 褫干净 */
-        foreach (QTreeWidgetItem *poItem, gmapCurveItem.values())
+    /* 右手边，tableWidget 褫干净 */
+    foreach (QTreeWidgetItem *poItem, gmapCurveItem.values())
+    {
+        if(poItem != NULL)
         {
-            if(poItem != NULL)
-            {
-                disconnect(ui->treeWidgetLegend, SIGNAL(itemChanged(QTreeWidgetItem*,int)), this, SLOT(shiftCurveSelect(QTreeWidgetItem*,int)));
-                delete poItem;
-                poItem == NULL;
-            }
+            disconnect(ui->treeWidgetLegend, SIGNAL(itemChanged(QTreeWidgetItem*,int)), this, SLOT(shiftCurveSelect(QTreeWidgetItem*,int)));
+            delete poItem;
+            poItem == NULL;
         }
-        gmapCurveItem.clear();
+    }
+    gmapCurveItem.clear();
 
-        ui->treeWidgetLegend->clear();
+    ui->treeWidgetLegend->clear();
 
-        ui->plotCurve->setTitle("");
+    ui->plotCurve->setTitle("");
 
-        aoStrExisting.clear();
+    aoStrExisting.clear();
 
-        /*  */
-        ui->actionClear->setEnabled(false);
+    /*  */
+    ui->actionClear->setEnabled(false);
 
-        /* 发射端和接收端数据都清除了,关闭 剪裁 功能*/
-        ui->actionCutterH->setEnabled(false);
-        ui->actionCutterV->setEnabled(false);
+    /* 发射端和接收端数据都清除了,关闭 剪裁 功能*/
+    ui->actionCutterH->setEnabled(false);
+    ui->actionCutterV->setEnabled(false);
 
-        ui->plotCurve->setFooter("");
+    ui->plotCurve->setFooter("");
 
-        gpoSelectedCurve = NULL;
-        giSelectedIndex = -1;
-        gpoErrorCurve = NULL;
+    gpoSelectedCurve = NULL;
+    giSelectedIndex = -1;
+    gpoErrorCurve = NULL;
 
-        gpoSelectedRX = NULL;
+    gpoSelectedRX = NULL;
 
-        ui->plotCurve->detachItems();
+    ui->plotCurve->detachItems();
 
-        /* 返回去设置指针为空就完事了 */
-        poPickerCurve->setNull();
+    /* 返回去设置指针为空就完事了 */
+    poPickerCurve->setNull();
 
-        ui->plotCurve->replot();
+    ui->plotCurve->replot();
+}
 
-        qDebugV0()<<"clear~~~";
-    }
+/* 清掉视电阻率曲线，数据库中的不动 */
+void MainWindow::clearRho()
+{
+    gmapCurveStation.clear();
+
+    ui->plotRho->detachItems();
+
+    gpoSelectedCurve = NULL;
+
+    poPickerRho->setNULL();
+
+    ui->plotRho->replot();
 }
 
 /* 显示提示信息，QMessage自动定时关闭。 */
@@ -516,7 +962,7 @@ void MainWindow::recoveryCurve(QwtPlotCurve *poCurve)
     QPolygonF aoPointF;
     aoPointF.clear();
 
-    aoPointF = this->getR(gpoSelectedRX->mapAvg);
+    aoPointF = this->getR(gpoSelectedRX);
 
     poCurve->setSamples(aoPointF);
 
@@ -544,11 +990,11 @@ void MainWindow::store()
 
         QTextStream out(&file);
 
-        foreach (double dF, poRx->mapScatterList.keys())
+        foreach (double dF, poRx->adF)
         {
             out<<dF<<",";
 
-            foreach(double dScatter,  poRx->mapScatterList.value(dF))
+            foreach(double dScatter,  poRx->scatter(dF))
             {
                 out<<dScatter<<",";
             }
@@ -646,35 +1092,122 @@ void MainWindow::drawCurve()
         poCurve->setSymbol( poSymbol );
         poCurve->setStyle(QwtPlotCurve::Lines);
 
-        QPolygonF aoPointF;
-        aoPointF.clear();
-        aoPointF = this->getR( poRX->mapAvg);
+        QPolygonF aoPointF;
+        aoPointF.clear();
+        aoPointF = this->getR(poRX);
+
+        poCurve->setSamples( aoPointF );
+        poCurve->setAxes(QwtPlot::xBottom, QwtPlot::yLeft);
+        poCurve->attach(ui->plotCurve);
+        poCurve->setVisible( true );
+
+        gmapCurveData.insert(poCurve, poRX);
+
+        QTreeWidgetItem *poItem = NULL;
+        poItem = new QTreeWidgetItem(ui->treeWidgetLegend, QStringList({poCurve->title().text(),"",""}));
+
+        poItem->setData(1, Qt::CheckStateRole, Qt::Checked);
+        poItem->setData(2, Qt::CheckStateRole, Qt::Unchecked);
+
+        gmapCurveItem.insert(poCurve, poItem);
+    }
+
+    connect(ui->treeWidgetLegend, SIGNAL(itemChanged(QTreeWidgetItem*,int)), this, SLOT(shiftCurveSelect(QTreeWidgetItem*,int)));
+
+
+    gpoSelectedCurve = NULL;
+    giSelectedIndex = -1;
+
+    gpoSelectedRX = NULL;
+
+    gpoErrorCurve = NULL;
+
+    ui->plotCurve->replot();
+}
+
+/**********************************************************************
+ * 追加读取到了新频点：只更新(插入)对应曲线上的这些点，不重建全部曲线
+ *
+ */
+void MainWindow::extendCurve(RX *poRX, QVector<double> adNewF)
+{
+    QwtPlotCurve *poCurve = gmapCurveData.key(poRX, NULL);
+
+    if(poCurve == NULL)
+    {
+        return;
+    }
+
+    QPolygonF aoPointF;
+
+    for(uint i = 0; i < poCurve->dataSize(); i++)
+    {
+        aoPointF.append(poCurve->sample(i));
+    }
+
+    QList<double> adTicks = ui->plotCurve->axisScaleDiv(QwtPlot::xBottom).ticks(QwtScaleDiv::MajorTick);
 
-        poCurve->setSamples( aoPointF );
-        poCurve->setAxes(QwtPlot::xBottom, QwtPlot::yLeft);
-        poCurve->attach(ui->plotCurve);
-        poCurve->setVisible( true );
+    bool bNewTick = false;
 
-        gmapCurveData.insert(poCurve, poRX);
+    foreach(double dF, adNewF)
+    {
+        QPointF oPointF(dF, poRX->avg(dF)/poDb->getI(dF));
 
-        QTreeWidgetItem *poItem = NULL;
-        poItem = new QTreeWidgetItem(ui->treeWidgetLegend, QStringList({poCurve->title().text(),"",""}));
+        /* 曲线上的点按频率升序排列 */
+        int i = 0;
 
-        poItem->setData(1, Qt::CheckStateRole, Qt::Checked);
-        poItem->setData(2, Qt::CheckStateRole, Qt::Unchecked);
+        while(i < aoPointF.count() && aoPointF.at(i).x() < dF)
+        {
+            i++;
+        }
 
-        gmapCurveItem.insert(poCurve, poItem);
+        if(i < aoPointF.count() && aoPointF.at(i).x() == dF)
+        {
+            aoPointF.replace(i, oPointF);
+        }
+        else
+        {
+            aoPointF.insert(i, oPointF);
+
+            /* 选中点之前插入了新点，选中点的序号跟着后移 */
+            if(poCurve == gpoSelectedCurve && i <= giSelectedIndex)
+            {
+                giSelectedIndex++;
+            }
+        }
+
+        if(!adTicks.contains(dF))
+        {
+            adTicks.append(dF);
+            bNewTick = true;
+        }
     }
 
-    connect(ui->treeWidgetLegend, SIGNAL(itemChanged(QTreeWidgetItem*,int)), this, SLOT(shiftCurveSelect(QTreeWidgetItem*,int)));
+    poCurve->setSamples(aoPointF);
 
+    if(bNewTick)
+    {
+        qSort(adTicks);
 
-    gpoSelectedCurve = NULL;
-    giSelectedIndex = -1;
+        QList<double> aadTicks[QwtScaleDiv::NTickTypes];
+        aadTicks[QwtScaleDiv::MajorTick] = adTicks;
+        QwtScaleDiv oScaleDiv( adTicks.last(), adTicks.first(), aadTicks );
 
-    gpoSelectedRX = NULL;
+        ui->plotCurve->setAxisScaleDiv( QwtPlot::xBottom, oScaleDiv );
+    }
 
-    gpoErrorCurve = NULL;
+    /* 正在看这条曲线的误差 */
+    if(poCurve == gpoSelectedCurve && gpoErrorCurve != NULL)
+    {
+        QPolygonF aoPointFError;
+
+        for(int i = 0; i < poRX->adF.count(); i++)
+        {
+            aoPointFError.append(QPointF(poRX->adF.at(i), poRX->adErr.at(i)));
+        }
+
+        gpoErrorCurve->setSamples( aoPointFError );
+    }
 
     ui->plotCurve->replot();
 }
@@ -703,21 +1236,21 @@ void MainWindow::resizeScaleScatter()
 }
 
 /* 电压除以电流，得到电阻值。实际上就是用电流来归一化电压 */
-QPolygonF MainWindow::getR(QMap<double, double> oMap)
+QPolygonF MainWindow::getR(RX *poRX)
 {
     QPolygonF aoPointF;
-    aoPointF.clear();
+    aoPointF.reserve(poRX->adF.count());
 
-    QMap<double, double>::const_iterator it;
-
-    for(it = oMap.constBegin(); it != oMap.constEnd(); ++it)
+    for(int i = 0; i < poRX->adF.count(); i++)
     {
-        double dI = poDb->getI(it.key());
+        double dF = poRX->adF.at(i);
+
+        double dI = poDb->getI(dF);
 
         QPointF oPointF;
 
-        oPointF.setX(it.key());
-        oPointF.setY(it.value()/dI);
+        oPointF.setX(dF);
+        oPointF.setY(poRX->adAvg.at(i)/dI);
 
         aoPointF.append(oPointF);
     }
@@ -1057,7 +1590,7 @@ void MainWindow::Selected(QwtPlotCurve *poCurve, int iIndex)
     QString oStrFooter(QString("%1_%2Hz_%3%")
                        .arg(poCurve->title().text())
                        .arg(poCurve->data()->sample(iIndex).x())
-                       .arg(QString::number(poRxSelected->mapErr.value(gpoSelectedCurve->sample(giSelectedIndex).x()),'f',2)));
+                       .arg(QString::number(poRxSelected->err(gpoSelectedCurve->sample(giSelectedIndex).x()),'f',2)));
     QwtText oTxt;
     oTxt.setText(oStrFooter);
     QFont oFont("Times New Roman", 12, QFont::Bold);
@@ -1118,15 +1651,17 @@ void MainWindow::markerMoved()
         return;
     }
 
-    QVector<qreal> arE;
-    arE.clear();
+    QVector<double> arE(apoPointScatter.count());
 
     for(qint32 i = 0; i < apoPointScatter.count(); i++)
     {
-        arE.append(apoPointScatter.at(i).y());
+        arE[i] = apoPointScatter.at(i).y();
     }
 
-    double dE = gpoSelectedRX->getAvg(arE);
+    /* 平均值和误差一次算出 */
+    double dE = 0, dErr = 0;
+
+    Stats::meanRelErr(arE.constData(), arE.count(), &dE, &dErr);
 
     double dI = poDb->getI(gpoSelectedCurve->data()->sample(giSelectedIndex).x());
 
@@ -1151,7 +1686,7 @@ void MainWindow::markerMoved()
     }
 
     /* Selected point's new value(just Y) */
-    QPointF oPointF( gpoErrorCurve->data()->sample(giSelectedIndex).x(), gpoSelectedRX->getErr(arE) );
+    QPointF oPointF( gpoErrorCurve->data()->sample(giSelectedIndex).x(), dErr );
 
     /* Replace current selected point Y value. */
     aoPointFError.replace( giSelectedIndex, oPointF );
@@ -1164,7 +1699,7 @@ void MainWindow::markerMoved()
     QString oStrFooter(QString("%1_%2Hz_%3%")
                        .arg(gpoSelectedCurve->title().text())
                        .arg(gpoSelectedCurve->data()->sample(giSelectedIndex).x())
-                       .arg(QString::number(gpoSelectedRX->getErr(arE),'f',2)));
+                       .arg(QString::number(dErr,'f',2)));
 
 
     ui->plotCurve->setFooter(oStrFooter);
@@ -1218,7 +1753,7 @@ void MainWindow::drawScatter()
 
     RX *poRxSelected = gmapCurveData.value(gpoSelectedCurve);
 
-    QVector<double> adScatter = poRxSelected->mapScatterList.value(gpoSelectedCurve->sample(giSelectedIndex).x());
+    QVector<double> adScatter = poRxSelected->scatter(gpoSelectedCurve->sample(giSelectedIndex).x());
 
     QVector<double> adX;
     adX.clear();
@@ -1247,7 +1782,7 @@ void MainWindow::drawScatter()
     QString oStrFooter(QString("%1_%2Hz_%3%")
                        .arg(gpoSelectedCurve->title().text())
                        .arg(gpoSelectedCurve->data()->sample(giSelectedIndex).x())
-                       .arg(QString::number(poRxSelected->mapErr.value(gpoSelectedCurve->sample(giSelectedIndex).x()),'f',2)));
+                       .arg(QString::number(poRxSelected->err(gpoSelectedCurve->sample(giSelectedIndex).x()),'f',2)));
 
 
     ui->plotCurve->setFooter(oStrFooter);
@@ -1256,6 +1791,7 @@ void MainWindow::drawScatter()
 
     /* 都已经挑数据了,还添加什么文件,先干啥去了~? */
     ui->actionImportRX->setEnabled(false);
+    ui->actionImportDir->setEnabled(false);
 
     /*  */
     ui->actionRecovery->setEnabled(true);
@@ -1307,10 +1843,9 @@ void MainWindow::drawError()
 
     QPolygonF aoPointF;
     aoPointF.clear();
-    QMap<double, double>::const_iterator it;
-    for(it = poRX->mapErr.constBegin(); it!= poRX->mapErr.constEnd(); ++it)
+    for(int i = 0; i < poRX->adF.count(); i++)
     {
-        aoPointF.append(QPointF(it.key(), it.value()));
+        aoPointF.append(QPointF(poRX->adF.at(i), poRX->adErr.at(i)));
     }
 
     gpoErrorCurve->setSamples( aoPointF );
@@ -1351,6 +1886,12 @@ void MainWindow::drawTx(const QVector<double> adF, const QVector<double> adI)
 
     qSort(listF);
 
+    /* 项目里还没有电流 */
+    if(listF.isEmpty())
+    {
+        return;
+    }
+
     /* Fill ticks */
     QList<double> adTicks[QwtScaleDiv::NTickTypes];
     adTicks[QwtScaleDiv::MajorTick] = listF;
@@ -1470,6 +2011,11 @@ void MainWindow::drawRx()
 
     qDebugV0()<<adF;
 
+    if(adF.isEmpty())
+    {
+        return;
+    }
+
     /* Fill ticks */
     QList<double> adTicks[QwtScaleDiv::NTickTypes];
     adTicks[QwtScaleDiv::MajorTick] = adF;
@@ -1505,7 +2051,7 @@ void MainWindow::drawRx()
 
         QPolygonF aoPointF;
         aoPointF.clear();
-        aoPointF = this->getR( poRX->mapAvg);
+        aoPointF = this->getR(poRX);
 
         poCurve->setSamples( aoPointF );
         poCurve->setAxes(QwtPlot::xBottom, QwtPlot::yLeft);
@@ -1640,7 +2186,7 @@ void MainWindow::restoreCurve()
     {
         QPolygonF aoPointF;
         aoPointF.clear();
-        aoPointF = this->getR( poRX->mapAvg);
+        aoPointF = this->getR(poRX);
 
         gpoSelectedCurve->setSamples( aoPointF );
 
@@ -1653,10 +2199,9 @@ void MainWindow::restoreCurve()
     {
         QPolygonF aoPointF;
         aoPointF.clear();
-        QMap<double, double>::const_iterator it;
-        for(it = poRX->mapErr.constBegin(); it!= poRX->mapErr.constEnd(); ++it)
+        for(int i = 0; i < poRX->adF.count(); i++)
         {
-            aoPointF.append(QPointF(it.key(), it.value()));
+            aoPointF.append(QPointF(poRX->adF.at(i), poRX->adErr.at(i)));
         }
 
         gpoErrorCurve->setSamples( aoPointF );
@@ -1983,8 +2528,17 @@ void MainWindow::on_actionExportRho_triggered()
 
     QAbstractItemModel *poModel = ui->tableViewRho->model();
 
+    /* 表格只取了显示到的行，导出前取完 */
+    while(poModel->canFetchMore(QModelIndex()))
+    {
+        poModel->fetchMore(QModelIndex());
+    }
+
+    /* 文件格式固定为前DB_RHO_FILE_COLUMNS列，导入时按同样的列读回 */
+    int iColumns = qMin(poModel->columnCount(), DB_RHO_FILE_COLUMNS);
+
     /* 列头 */
-    for(int i = 0; i < poModel->columnCount(); i++)
+    for(int i = 0; i < iColumns; i++)
     {
         outStream<<poModel->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString()<<",";
     }
@@ -1992,7 +2546,7 @@ void MainWindow::on_actionExportRho_triggered()
 
     for(int i = 0; i < poModel->rowCount(); i++)
     {
-        for(int j = 0 ; j < poModel->columnCount(); j++)
+        for(int j = 0 ; j < iColumns; j++)
         {
             outStream<<poModel->data(poModel->index(i,j), Qt::DisplayRole).toString()<<",";
         }
@@ -2071,12 +2625,11 @@ void MainWindow::on_actionSave_triggered()
         return;
     }
 
-    QVector<double> adY;
-    adY.clear();
+    QVector<double> adY(aoPointF.count());
 
     for(qint32 i = 0; i < aoPointF.count(); i++)
     {
-        adY.append(aoPointF.at(i).y());
+        adY[i] = aoPointF.at(i).y();
     }
 
     RX *poRX = gmapCurveData.value(gpoSelectedCurve);
@@ -2119,27 +2672,13 @@ void MainWindow::on_actionStore_triggered()
         break;
 
     case 1://广域视电阻率调整后，保存结果至数据库，以备export
-    {
-        QMap<QwtPlotCurve*, STATION>::const_iterator it;
-        for(it = gmapCurveStation.constBegin(); it!= gmapCurveStation.constEnd(); it++)
-        {
-            QPolygonF aoPointF;
-            aoPointF.clear();
-
-            for(uint i = 0; i < it.key()->dataSize(); i++)
-            {
-                // qDebugV0()<<it.key()->sample(i);
-                aoPointF.append(it.key()->sample(i));
-            }
+        this->storeRho();
 
-            poDb->modifyRho(it.value(), aoPointF);
+        /* 中间结果保存完了之后,将store键置为Disable */
+        ui->actionStore->setEnabled(false);
+        /* 保存了之后就置false */
+        bModifyRho = false;
 
-            /* 中间结果保存完了之后,将store键置为Disable */
-            ui->actionStore->setEnabled(false);
-            /* 保存了之后就置false */
-            bModifyRho = false;
-        }
-    }
         break;
     default:
         break;
@@ -2172,21 +2711,21 @@ void MainWindow::on_actionCalRho_triggered()
 
     QList<STATION> aoStation = poDb->getStation("RX");
 
-    gmapCurveStation.clear();
-
-    ui->plotRho->detachItems();
+    this->clearRho();
 
-    gpoSelectedCurve = NULL;
+    poDb->cleanRho();
 
-    poPickerRho->setNULL();
+    /* 各站点在线程池中并行计算，每算完一个会发射一个信号，main线程会draw Rho曲线。
+     * 进度框模态，计算期间不能再动数据；可以取消 */
+    gpoRhoProgress = new QProgressDialog("正在计算广域视电阻率...", "取消", 0, aoStation.count(), this);
+    gpoRhoProgress->setWindowModality(Qt::WindowModal);
+    gpoRhoProgress->setMinimumDuration(0);
+    gpoRhoProgress->setAutoClose(false);
+    gpoRhoProgress->setAutoReset(false);
 
-    poDb->cleanRho();
+    connect(gpoRhoProgress, SIGNAL(canceled()), poCalRho, SLOT(cancel()));
 
-    /* 每条曲线一个thread，每个thread计算完毕了，会发射一个信号，main线程会draw Rho曲线 */
-    foreach(STATION oStation, aoStation)
-    {
-        poCalRho->CalRho(oStation);
-    }
+    poCalRho->CalRho(aoStation);
 
     //ui->actionClear->setEnabled(false);
     ui->actionCutterH->setEnabled(false);
@@ -2194,6 +2733,7 @@ void MainWindow::on_actionCalRho_triggered()
     ui->actionExportRho->setEnabled(true);
     ui->actionImportRX->setEnabled(false);
     ui->actionImportTX->setEnabled(false);
+    ui->actionImportDir->setEnabled(false);
 
     ui->actionRecovery->setEnabled(true);
 
@@ -2267,6 +2807,11 @@ void MainWindow::showTableRho(CustomTableModel *poModel)
 /* 画广域视电阻率曲线图，是按了计算Rho按钮，然后计算，计算完了发信号过来， */
 void MainWindow::drawRho(STATION oStation, QVector<double> adF, QVector<double> adRho)
 {
+    if(adF.isEmpty())
+    {
+        return;
+    }
+
     QSet<double> setF;
 
     foreach(double dF, adF)
@@ -2348,6 +2893,10 @@ void MainWindow::on_actionImportRho_triggered()
 
     poDb->cleanRho();
 
+    QStringList aoStrErr;
+
+    int iErrCnt = 0;
+
     foreach(QString oStrRho, aoStrRhoFileName)
     {
         QFile oFile(oStrRho);
@@ -2356,68 +2905,177 @@ void MainWindow::on_actionImportRho_triggered()
             return;
         }
 
+        QByteArray aoData = oFile.readAll();
+
+        oFile.close();
+
         QList<RhoResult> aoRho;
         aoRho.clear();
-        QTextStream oStream(&oFile);
+
+        CsvReader oReader(aoData.constData(), aoData.constData() + aoData.size());
+
+        QVector<CSV_FIELD> aoField;
 
         /* 首行是列头 */
-        oStream.readLine();
+        oReader.readLine();
 
-        while( !oStream.atEnd() )
+        while( oReader.readLine() )
         {
-            QString oStrLine = oStream.readLine();
-            QStringList aoStrLine = oStrLine.split(",", QString::SkipEmptyParts);
+            if(oReader.isEmptyLine())
+            {
+                continue;
+            }
 
-            RhoResult oRho;
+            if(oReader.split(&aoField) < DB_RHO_FILE_COLUMNS)
+            {
+                oReader.error(QString("应为%1列，实际%2列").arg(DB_RHO_FILE_COLUMNS).arg(aoField.count()));
+                continue;
+            }
+
+            /* 第6列起都是数值(第9列误差带%)，先全部解析 */
+            double adValue[DB_RHO_FILE_COLUMNS];
+
+            bool bOk = CsvReader::toDouble(aoField.at(5), &adValue[5]) &&
+                    CsvReader::toDouble(aoField.at(6), &adValue[6]) &&
+                    CsvReader::toDouble(aoField.at(7), &adValue[7]);
+
+            for(int i = 9; i < DB_RHO_FILE_COLUMNS && bOk; i++)
+            {
+                bOk = CsvReader::toDouble(aoField.at(i), &adValue[i]);
+            }
+
+            /* 剃掉% */
+            CSV_FIELD sErr = aoField.at(8);
+
+            if(sErr.pcEnd > sErr.pcBegin && *(sErr.pcEnd - 1) == '%')
+            {
+                sErr.pcEnd--;
+            }
+
+            bOk = bOk && CsvReader::toDouble(sErr, &adValue[8]);
 
             STATION oStation;
-            oStation.oStrLineId = aoStrLine.at(0);
-            oStation.oStrSiteId = aoStrLine.at(1);
-            oStation.iDevId = aoStrLine.at(2).toInt();
-            oStation.iDevCh = aoStrLine.at(3).toInt();
-            oStation.oStrTag = aoStrLine.at(4);
+
+            bOk = bOk && CsvReader::toInt(aoField.at(2), &oStation.iDevId)
+                    && CsvReader::toInt(aoField.at(3), &oStation.iDevCh);
+
+            if(!bOk)
+            {
+                oReader.error("数值无法解析");
+                continue;
+            }
+
+            RhoResult oRho;
+
+            oStation.oStrLineId = CsvReader::toString(aoField.at(0));
+            oStation.oStrSiteId = CsvReader::toString(aoField.at(1));
+            oStation.oStrTag = CsvReader::toString(aoField.at(4));
             oRho.oStation = oStation;
 
-            oRho.dF = aoStrLine.at(5).toDouble();
-            oRho.dI = aoStrLine.at(6).toDouble();
+            oRho.dF = adValue[5];
+            oRho.dI = adValue[6];
 
-            oRho.dField = aoStrLine.at(7).toDouble();
-            QString oStrEr = aoStrLine.at(8);
+            oRho.dField = adValue[7];
 
-            /* 剃掉% */
-            oStrEr.chop(1);
+            oRho.dErr = adValue[8];
 
-            oRho.dErr = oStrEr.toDouble();
+            oRho.dRho = adValue[9];
 
-            oRho.dRho = aoStrLine.at(9).toDouble();
+            /* 导入的文件不带反演诊断，按未反演入库 */
+            oRho.iIter = 0;
+            oRho.dResidual = 0;
+            oRho.bConverged = false;
+            oRho.iKernel = 0;
 
             Position oAB;
-            oAB.dMX = aoStrLine.at(10).toDouble();
-            oAB.dMY = aoStrLine.at(11).toDouble();
-            oAB.dMZ = aoStrLine.at(12).toDouble();
-            oAB.dNX = aoStrLine.at(13).toDouble();
-            oAB.dNY = aoStrLine.at(14).toDouble();
-            oAB.dNZ = aoStrLine.at(15).toDouble();
+            oAB.dMX = adValue[10];
+            oAB.dMY = adValue[11];
+            oAB.dMZ = adValue[12];
+            oAB.dNX = adValue[13];
+            oAB.dNY = adValue[14];
+            oAB.dNZ = adValue[15];
             oRho.oAB = oAB;
 
             Position oMN;
-            oMN.dMX = aoStrLine.at(16).toDouble();
-            oMN.dMY = aoStrLine.at(17).toDouble();
-            oMN.dMZ = aoStrLine.at(18).toDouble();
-            oMN.dNX = aoStrLine.at(19).toDouble();
-            oMN.dNY = aoStrLine.at(20).toDouble();
-            oMN.dNZ = aoStrLine.at(21).toDouble();
+            oMN.dMX = adValue[16];
+            oMN.dMY = adValue[17];
+            oMN.dMZ = adValue[18];
+            oMN.dNX = adValue[19];
+            oMN.dNY = adValue[20];
+            oMN.dNZ = adValue[21];
             oRho.oMN = oMN;
 
             aoRho.append( oRho );
         }
 
-        oFile.close();
+        iErrCnt += oReader.errorCount();
+
+        foreach(QString oStrErr, oReader.errors())
+        {
+            aoStrErr.append(QString("%1 %2").arg(QFileInfo(oStrRho).fileName()).arg(oStrErr));
+        }
 
         poDb->importRho(aoRho);
     }
 
+    if(!aoStrErr.isEmpty())
+    {
+        QMessageBox oMsgBox(QMessageBox::Warning, "警告",
+                            QString("视电阻率文件中有%1行格式有误，已忽略。").arg(iErrCnt),
+                            QMessageBox::Ok, this);
+        oMsgBox.setDetailedText(aoStrErr.join("\n"));
+        oMsgBox.exec();
+    }
+
     /* draw Rho curve */
+    this->clearRho();
+
+    this->drawStoredRho();
+
+    /* Manual adjustment of apparent resistivity curve */
+    ui->actionCutterH->setEnabled(false);
+    ui->actionCutterV->setEnabled(false);
+    ui->actionExportRho->setEnabled(true);
+    ui->actionImportRX->setEnabled(false);
+    ui->actionImportTX->setEnabled(false);
+    ui->actionImportDir->setEnabled(false);
+
+    ui->actionRecovery->setEnabled(true);
+
+    ui->actionSave->setEnabled(false);
+    ui->actionStore->setEnabled(false);
+
+    ui->actionCalRho->setEnabled(true);
+
+    ui->stackedWidget->setCurrentIndex(1);
+}
+
+/* 全部Rho曲线上的点一次写回数据库 */
+void MainWindow::storeRho()
+{
+    QList<STATION> aoStation;
+    QList<QPolygonF> aaoPointF;
+
+    QMap<QwtPlotCurve*, STATION>::const_iterator it;
+    for(it = gmapCurveStation.constBegin(); it!= gmapCurveStation.constEnd(); it++)
+    {
+        QPolygonF aoPointF;
+
+        for(uint i = 0; i < it.key()->dataSize(); i++)
+        {
+            aoPointF.append(it.key()->sample(i));
+        }
+
+        aoStation.append(it.value());
+        aaoPointF.append(aoPointF);
+    }
+
+    poDb->modifyRho(aoStation, aaoPointF);
+}
+
+/* 从数据库读出视电阻率，每个站点画一条曲线，返回站点数 */
+int MainWindow::drawStoredRho()
+{
     QList<STATION> aoStation = poDb->getStation("Rho");
 
     foreach(STATION oStation, aoStation)
@@ -2436,19 +3094,190 @@ void MainWindow::on_actionImportRho_triggered()
         }
         this->drawRho(oStation, adF, adRho);
     }
-    /* Manual adjustment of apparent resistivity curve */
-    ui->actionCutterH->setEnabled(false);
-    ui->actionCutterV->setEnabled(false);
-    ui->actionExportRho->setEnabled(true);
-    ui->actionImportRX->setEnabled(false);
-    ui->actionImportTX->setEnabled(false);
 
-    ui->actionRecovery->setEnabled(true);
+    return aoStation.count();
+}
 
-    ui->actionSave->setEnabled(false);
-    ui->actionStore->setEnabled(false);
+/******************************************************************************
+ * 打开项目：表格直接从数据库恢复；记下的电场文件重新读入(有.rxc缓存时不必解析)，
+ * 改过的重新解析，找不到的列在提示框明细里；有视电阻率时画出曲线。
+ */
+void MainWindow::openProject(QString oStrDbFile)
+{
+    /* 上一个项目的曲线 */
+    if(!gapoRX.isEmpty())
+    {
+        this->clearRX();
+    }
 
-    ui->actionCalRho->setEnabled(true);
+    if(!gmapCurveStation.isEmpty())
+    {
+        this->clearRho();
+    }
 
-    ui->stackedWidget->setCurrentIndex(1);
+    bModifyField = false;
+    bModifyRho   = false;
+
+    ui->actionImportDir->setEnabled(true);
+    ui->actionExportRho->setEnabled(false);
+    ui->actionRecovery->setEnabled(false);
+
+    poDb->connect(oStrDbFile);
+
+    this->LastProjectWrite(oStrDbFile);
+
+    this->setWindowTitle(QString("%1 - %2").arg(goStrTitle).arg(QFileInfo(oStrDbFile).fileName()));
+
+    /* 有了电流才能导入电场 */
+    QStringList aoStrTX = poDb->getSource("TX");
+
+    ui->actionImportTX->setEnabled(true);
+    ui->actionImportRX->setEnabled(!aoStrTX.isEmpty());
+
+    if(!aoStrTX.isEmpty())
+    {
+        ui->plotTx->setFooter("电流文件："+aoStrTX.first());
+    }
+
+    QStringList aoStrRX, aoStrErr;
+
+    foreach(QString oStrFile, poDb->getSource("RX"))
+    {
+        if(poDb->sourceState(oStrFile) == SOURCE_MISSING)
+        {
+            aoStrErr.append(QString("%1：文件不存在").arg(oStrFile));
+        }
+        else
+        {
+            aoStrRX.append(oStrFile);
+        }
+    }
+
+    QVector<RX*> apoRX = this->loadRX(aoStrRX, aoStrErr);
+
+    if(!apoRX.isEmpty() || !aoStrErr.isEmpty())
+    {
+        this->appendRX(apoRX, aoStrErr, aoStrRX.isEmpty() ? QString() : aoStrRX.last());
+    }
+
+    /* 画RX表格的曲线要用上面读入的RX */
+    poDb->restore();
+
+    if(this->drawStoredRho() > 0)
+    {
+        ui->actionExportRho->setEnabled(true);
+        ui->actionRecovery->setEnabled(true);
+
+        ui->stackedWidget->setCurrentIndex(1);
+    }
+
+    qDebugV0()<<"Project:"<<oStrDbFile<<"TX:"<<aoStrTX.count()<<"RX:"<<apoRX.count();
+}
+
+/* 打开或新建项目，选已有的文件就是打开 */
+void MainWindow::on_actionOpenProject_triggered()
+{
+    QString oStrDbFile = QFileDialog::getSaveFileName(this,
+                                                      "打开或新建项目",
+                                                      QFileInfo(poDb->project()).absolutePath(),
+                                                      "项目文件(*.db)",
+                                                      NULL,
+                                                      QFileDialog::DontConfirmOverwrite);
+
+    if(oStrDbFile.isEmpty() ||
+            QFileInfo(oStrDbFile).absoluteFilePath() == QFileInfo(poDb->project()).absoluteFilePath())
+    {
+        return;
+    }
+
+    if( bModifyField )
+    {
+        QMessageBox oMsgBoxStore(QMessageBox::Question, "保存？", "是否保存修改后的\n电位数据？",
+                                 QMessageBox::Yes | QMessageBox::No, NULL);
+        if(oMsgBoxStore.exec() == QMessageBox::Yes)
+        {
+            this->store();
+        }
+    }
+
+    /* 圆滑后的视电阻率存在当前项目里，换项目之前存 */
+    if( bModifyRho )
+    {
+        QMessageBox oMsgBoxRho(QMessageBox::Question, "保存？", "是否保存圆滑后的\n电阻率数据？",
+                               QMessageBox::Yes | QMessageBox::No, NULL);
+
+        if(oMsgBoxRho.exec() == QMessageBox::Yes)
+        {
+            this->storeRho();
+        }
+    }
+
+    this->openProject(oStrDbFile);
+}
+
+/* 上次打开的项目，没有记录时用默认项目；记录和默认项目都在程序目录下，与启动时的工作目录无关 */
+QString MainWindow::LastProjectRead()
+{
+    QString oStrDbFile;
+
+    QFile oFileLastProject(RunningDir + "/" + LASTPROJECT);
+
+    if( oFileLastProject.open(QIODevice::ReadOnly | QIODevice::Text) )
+    {
+        QTextStream oTextStreamIn(&oFileLastProject);
+        oTextStreamIn.setCodec("UTF-8");
+
+        oStrDbFile = oTextStreamIn.readLine();
+
+        oFileLastProject.close();
+    }
+
+    if(oStrDbFile.isEmpty())
+    {
+        oStrDbFile = RunningDir + "/" + DB_DEFAULT_FILE;
+    }
+
+    return oStrDbFile;
+}
+
+void MainWindow::LastProjectWrite(QString oStrDbFile)
+{
+    QFile oFileLastProject(RunningDir + "/" + LASTPROJECT);
+
+    if( !oFileLastProject.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+    {
+        qDebugV0()<<"Open last project file false!";
+        return;
+    }
+
+    QTextStream oTextStreamOut(&oFileLastProject);
+    oTextStreamOut.setCodec("UTF-8");
+
+    oTextStreamOut<<QFileInfo(oStrDbFile).absoluteFilePath();
+
+    oFileLastProject.close();
+}
+
+/* 计算进度，显示吞吐量 */
+void MainWindow::rhoProgress(int iDone, int iTotal, double dRate)
+{
+    if(gpoRhoProgress != NULL)
+    {
+        gpoRhoProgress->setMaximum(iTotal);
+        gpoRhoProgress->setValue(iDone);
+        gpoRhoProgress->setLabelText(QString("正在计算广域视电阻率：%1/%2，%3 站点/秒")
+                                     .arg(iDone).arg(iTotal).arg(dRate, 0, 'f', 1));
+    }
+}
+
+void MainWindow::rhoFinished(int iDone, int iTotal, double dRate)
+{
+    if(gpoRhoProgress != NULL)
+    {
+        gpoRhoProgress->deleteLater();
+        gpoRhoProgress = NULL;
+    }
+
+    ui->plotRho->setFooter(QString("已计算%1/%2个站点，%3 站点/秒。请选中线上的点！")
+                           .arg(iDone).arg(iTotal).arg(dRate, 0, 'f', 1));
 }
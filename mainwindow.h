@@ -20,6 +20,7 @@
 #include <QInputDialog>
 
 #include "Data/RX.h"
+#include "Common/Stats.h"
 #include "Picker/Canvaspicker.h"
 #include "Picker/MarkerPicker.h"
 
@@ -33,6 +34,10 @@
 #include <QDesktopServices>
 #include <QUrl>
 
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QProgressDialog>
+
 
 /* Marker line list */
 typedef struct _MARKER_LIST
@@ -44,6 +49,17 @@ typedef struct _MARKER_LIST
 
 }MARKER_LIST;
 
+/* 并行导入时，单个电场文件的导入结果 */
+typedef struct _RX_LOAD
+{
+    QString oStrFileName;
+
+    /* 失败时为NULL */
+    RX *poRX;
+
+    QString oStrErr;
+}RX_LOAD;
+
 namespace Ui {
 class MainWindow;
 }
@@ -124,7 +140,7 @@ private:
     /* Real time set plot canvas Scale & Set aside blank. */
     void resizeScaleScatter();
 
-    QPolygonF getR(QMap<double, double> oMap);
+    QPolygonF getR(RX *poRX);
 
     /* Read last Dir log file, get last Dir(Previous directory) */
     QString LastDirRead();
@@ -145,6 +161,53 @@ private:
 
     QStringList aoStrExisting;
 
+    /* 实时监视电场文件的定时器 */
+    QTimer *gpoWatchTimer;
+
+    /* 散点LRU缓存上限(MB) */
+    int giScatterBudgetMB;
+
+    /* 在线程池中并行导入电场文件，结果按aoStrFile的顺序返回，失败信息写入aoStrErr */
+    QVector<RX*> loadRX(QStringList aoStrFile, QStringList &aoStrErr);
+
+    /* 按内容去重，与aoStrExist中内容相同的也去掉 */
+    QStringList uniqueFiles(QStringList aoStrFile, QStringList aoStrExist, int *piDupCnt);
+
+    /* 导入完成的电场文件加入列表、画曲线，提示失败的文件 */
+    void appendRX(QVector<RX*> apoRX, QStringList aoStrErr, QString oStrLastFile);
+
+    /* 已导入的文件中，导入后内容又改过的 */
+    QStringList changedRX(QStringList aoStrFile);
+
+    /* 从列表中去掉这些文件的RX，重画曲线 */
+    void dropRX(QStringList aoStrFile);
+
+    /* 清掉全部RX和曲线，回到可以导入电流的状态 */
+    void clearRX();
+
+    /* 清掉广域视电阻率曲线 */
+    void clearRho();
+
+    /* 全部Rho曲线上的点一次写回数据库 */
+    void storeRho();
+
+    /* 从数据库读出各站点的视电阻率画曲线 */
+    int drawStoredRho();
+
+    /* 打开项目数据库，恢复表格、电场文件和视电阻率曲线 */
+    void openProject(QString oStrDbFile);
+
+    /* 上次打开的项目，没有时为程序目录(RunningDir)下的DB_DEFAULT_FILE */
+    QString LastProjectRead();
+
+    void LastProjectWrite(QString oStrDbFile);
+
+    /* 视电阻率计算的进度框，计算期间存在 */
+    QProgressDialog *gpoRhoProgress;
+
+    /* 窗口标题，后面加上项目名 */
+    QString goStrTitle;
+
     QMap<QwtPlotCurve*, STATION> gmapCurveStation;
 
     /*"Shift + Ctrl + R",恢复选中的Rho整条曲线 */
@@ -155,6 +218,8 @@ private slots:
 
     void on_actionImportRX_triggered();
 
+    void on_actionImportDir_triggered();
+
     /* 导出RX平均值供马工使用 */
     void on_actionExportRX_triggered();
 
@@ -197,10 +262,33 @@ private slots:
 
     void on_actionImportRho_triggered();
 
+    /* 打开或新建项目 */
+    void on_actionOpenProject_triggered();
+
+    /* 视电阻率计算的进度和结束 */
+    void rhoProgress(int iDone, int iTotal, double dRate);
+
+    void rhoFinished(int iDone, int iTotal, double dRate);
+
+    /* 开关电场文件的二进制缓存 */
+    void on_actionCache_toggled(bool bChecked);
+
+    /* 设置散点LRU缓存上限 */
+    void on_actionScatterBudget_triggered();
+
+    /* 开关电场文件的实时监视 */
+    void on_actionWatch_toggled(bool bChecked);
+
+    /* 定时追加读取所有电场文件 */
+    void watchRX();
+
 public slots:
     /* Draw Curve */
     void drawCurve();
 
+    /* 追加读取到了新频点，只更新对应曲线上的这些点 */
+    void extendCurve(RX *poRX, QVector<double> adNewF);
+
     /* Scatter changed, then, curve's point need be change. */
     void markerMoved();
 